@@ -0,0 +1,385 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <set>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "AsciiBatch.hpp"
+#include "AsciiCache.hpp"
+#include "AsciiPreview.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Converts a list of images with several worker	*/
+/*	processes, resuming from checkpoints after a crash		*/
+/************************************************************************/
+
+
+// Layout of a batch directory:
+//	shard-<k>.list	the manifest entries given to worker k, one "<index>\t<path>" per line
+//	shard-<k>.done	checkpoint for worker k, one "<index>\t<milliseconds>\t<started|ok|fail>\t<settings>\t<path>"
+//			as each entry is started and again once it is finished. <settings> is a hash of the
+//			conversion settings
+//	out/<index>.txt	the ascii art for manifest entry <index>
+//	out/<index>.png	its preview, if asked for (in whichever format was asked for)
+//	merged.txt	every result in manifest order, written by the coordinator at the end
+//	stats.txt	per shard timing, written by the coordinator at the end
+// Any host that mounts the batch directory can run a shard with "--worker <k> --batch-dir <dir>".
+// A worker skips whatever its checkpoint already lists, so a restarted shard carries on where it stopped.
+// An entry that was started but never finished is what crashed the last worker, so it is marked as
+// failed and skipped rather than tried again, and one bad image cannot hold up the rest of its shard.
+// A checkpoint entry only counts while its path and settings still match the shard list and the current
+// run, so rerunning over an old batch directory with an edited manifest, other settings or another
+// number of workers converts whatever changed rather than reusing stale results.
+
+namespace fs = std::filesystem;
+typedef std::chrono::steady_clock Clock;
+
+// one finished entry from a checkpoint file
+struct BatchRecord {
+	double ms;
+	bool ok;
+};
+
+/**************************************
+ * Helper Functions *******************
+ **************************************/
+
+static String shardList(String batchDir, int shard) {
+	return batchDir + "/shard-" + std::to_string(shard) + ".list";
+}
+
+static String shardCheckpoint(String batchDir, int shard) {
+	return batchDir + "/shard-" + std::to_string(shard) + ".done";
+}
+
+static String outputFile(String batchDir, int index, String extension = ".txt") {
+	char name[32];
+	snprintf(name, sizeof(name), "/out/%08d", index);
+	return batchDir + name + extension;
+}
+
+/* readLines: every non-blank line of a text file */
+static std::vector<String> readLines(String fileName) {
+	std::vector<String> lines;
+	std::ifstream in(fileName);
+	String line;
+	while (std::getline(in, line)) {
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (!line.empty()) lines.push_back(line);
+	}
+	return lines;
+}
+
+/* settingsKey: identifies everything about a run that changes its outputs */
+static String settingsKey(const BatchSettings& settings) {
+	return optionsKey(settings.opts) + settings.previewExt;
+}
+
+/* readCheckpoint: the entries a shard has already finished, by manifest index. Only entries made
+ *	with the same settings, for the same path as in the current shard list, are returned. A line
+ *	cut short by a crash is ignored too.
+ * String batchDir:	the batch directory
+ * int shard:		which shard's checkpoint to read
+ * String key:		the settingsKey of the current run
+ * std::set<int>* crashed:	if not NULL, set to the entries that were started but never finished
+*/
+static std::map<int, BatchRecord> readCheckpoint(String batchDir, int shard, String key, std::set<int>* crashed = NULL) {
+	std::map<int, String> paths;
+	for (const String& entry : readLines(shardList(batchDir, shard))) {
+		size_t tab = entry.find('\t');
+		if (tab != String::npos) paths[std::stoi(entry.substr(0, tab))] = entry.substr(tab + 1);
+	}
+
+	std::map<int, BatchRecord> done;
+	std::set<int> started;
+	for (const String& line : readLines(shardCheckpoint(batchDir, shard))) {
+		std::istringstream fields(line);
+		int index;
+		BatchRecord record;
+		String status, settings, path;
+		if (!(fields >> index >> record.ms >> status >> settings)) continue;
+		if (status != "ok" && status != "fail" && status != "started") continue;
+		fields.ignore(1);
+		std::getline(fields, path);
+
+		auto listed = paths.find(index);
+		if (settings != key || listed == paths.end() || listed->second != path) continue;
+		if (status == "started") {
+			started.insert(index);
+			continue;
+		}
+		record.ok = (status == "ok");
+		done[index] = record;
+	}
+	if (crashed) {
+		crashed->clear();
+		for (int index : started) {
+			if (done.find(index) == done.end()) crashed->insert(index);
+		}
+	}
+	return done;
+}
+
+/* appendCheckpoint: add one line to a shard's checkpoint. Returns false if it could not be written.
+ *	Appends of a single short line are atomic, so a crash leaves at worst one ignored partial line.
+*/
+static bool appendCheckpoint(int checkpoint, int index, double ms, String status, String key, String fileName) {
+	String line = std::to_string(index) + "\t" + std::to_string(ms) + "\t" + status + "\t" + key + "\t" + fileName + "\n";
+	return write(checkpoint, line.c_str(), line.size()) == (ssize_t)line.size();
+}
+
+static bool writeShardList(String batchDir, int shard, const String& list) {
+	return writeFileAtomic(shardList(batchDir, shard), list.c_str(), list.size());
+}
+
+/* shardComplete: whether every entry in a shard's list appears in its checkpoint */
+static bool shardComplete(String batchDir, int shard, String key) {
+	std::vector<String> entries = readLines(shardList(batchDir, shard));
+	std::map<int, BatchRecord> done = readCheckpoint(batchDir, shard, key);
+	for (const String& entry : entries) {
+		if (done.find(std::stoi(entry)) == done.end()) return false;
+	}
+	return true;
+}
+
+/* spawnWorker: start a copy of this program as worker shard, with the same arguments as the coordinator.
+ *	Returns the process id, or -1 if it could not be started.
+*/
+static pid_t spawnWorker(int shard, int argc, char** argv) {
+	String shardArg = std::to_string(shard);
+	std::vector<char*> args(argv, argv + argc);
+	args.push_back((char*)"--worker");
+	args.push_back((char*)shardArg.c_str());
+	args.push_back(NULL);
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		execv("/proc/self/exe", args.data());
+		execvp(argv[0], args.data());
+		_exit(127);
+	}
+	return pid;
+}
+
+/* mergeResults: gather every output into merged.txt in manifest order, and the checkpoints into stats.txt */
+static void mergeResults(String batchDir, const std::vector<String>& manifest, int workers, String key) {
+	std::map<int, BatchRecord> all;
+	std::ostringstream stats;
+	stats << "shard\tconverted\tfailed\ttotal_ms\tmean_ms\tmax_ms\n";
+	for (int shard = 0; shard < workers; shard++) {
+		std::map<int, BatchRecord> done = readCheckpoint(batchDir, shard, key);
+		int ok = 0, failed = 0;
+		double total = 0, slowest = 0;
+		for (const auto& item : done) {
+			all[item.first] = item.second;
+			if (item.second.ok) ok++;
+			else failed++;
+			total += item.second.ms;
+			slowest = std::max(slowest, item.second.ms);
+		}
+		stats << shard << "\t" << ok << "\t" << failed << "\t" << total << "\t"
+		      << (done.empty() ? 0 : total / done.size()) << "\t" << slowest << "\n";
+	}
+	String statsText = stats.str();
+	writeFileAtomic(batchDir + "/stats.txt", statsText.c_str(), statsText.size());
+	std::cerr << stats.str();
+
+	std::ofstream merged(batchDir + "/merged.txt", std::ios::trunc);
+	for (size_t i = 0; i < manifest.size(); i++) {
+		auto record = all.find((int)i);
+		merged << "==> " << manifest[i] << " <==\n";
+		if (record == all.end() || !record->second.ok) {
+			merged << "(failed)\n\n";
+			continue;
+		}
+		std::ifstream in(outputFile(batchDir, (int)i), std::ios::binary);
+		merged << in.rdbuf() << "\n\n";
+	}
+}
+
+
+/**************************************
+ * Batch Interface ********************
+ **************************************/
+
+/* runBatchCoordinator: split a manifest of images into shards, run a worker process on each, restart
+ *	any that crash, and merge the results. Returns 0 once every shard is complete.
+ * String manifest:		a text file listing one image path per line
+ * int workers:			the number of shards, and of worker processes
+ * bool spawn:			start the workers here. Otherwise wait for workers started by hand, on this
+ *				or any other host sharing the batch directory
+ * BatchSettings settings:	the batch directory and the conversion settings
+ * int argc, char** argv:	the coordinator's own arguments, passed on to the workers
+*/
+int runBatchCoordinator(String manifest, int workers, bool spawn, BatchSettings settings, int argc, char** argv) {
+	std::vector<String> images = readLines(manifest);
+	if (images.empty()) {
+		std::cout << "Could not read any images from the manifest " << manifest << std::endl;
+		return -1;
+	}
+	std::error_code ec;
+	fs::create_directories(settings.batchDir + "/out", ec);
+	if (ec) {
+		std::cout << "Could not create the batch directory " << settings.batchDir << std::endl;
+		return -1;
+	}
+
+	// deal entries out round robin so slow runs of similar images get spread over every shard. The split
+	// only depends on the manifest, so rerunning over an existing batch lines up with its checkpoints
+	std::vector<std::ostringstream> lists(workers);
+	for (size_t i = 0; i < images.size(); i++) {
+		lists[i % workers] << i << "\t" << images[i] << "\n";
+	}
+	for (int shard = 0; shard < workers; shard++) {
+		if (!writeShardList(settings.batchDir, shard, lists[shard].str())) {
+			std::cout << "Could not write the shard list for shard " << shard << std::endl;
+			return -1;
+		}
+	}
+
+	String key = settingsKey(settings);
+	Clock::time_point start = Clock::now();
+	int failedShards = 0;
+	if (spawn) {
+		std::map<pid_t, int> running;
+		std::vector<int> retries(workers, 0);
+		for (int shard = 0; shard < workers; shard++) {
+			if (shardComplete(settings.batchDir, shard, key)) continue;
+			pid_t pid = spawnWorker(shard, argc, argv);
+			if (pid > 0) running[pid] = shard;
+			else failedShards++;
+		}
+
+		while (!running.empty()) {
+			int status;
+			pid_t pid = wait(&status);
+			if (pid < 0) break;
+			auto worker = running.find(pid);
+			if (worker == running.end()) continue;
+			int shard = worker->second;
+			running.erase(worker);
+
+			if (WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+			if (++retries[shard] > MAX_SHARD_RETRIES) {
+				std::cerr << "shard " << shard << " keeps failing, giving up on it" << std::endl;
+				failedShards++;
+				continue;
+			}
+			std::cerr << "shard " << shard << " stopped early, resuming it from its checkpoint" << std::endl;
+			pid = spawnWorker(shard, argc, argv);
+			if (pid > 0) running[pid] = shard;
+			else failedShards++;
+		}
+	}
+	else {
+		// the workers run elsewhere, so just watch the checkpoints
+		for (;;) {
+			int remaining = 0;
+			for (int shard = 0; shard < workers; shard++) {
+				if (!shardComplete(settings.batchDir, shard, key)) remaining++;
+			}
+			if (remaining == 0) break;
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+		}
+	}
+
+	mergeResults(settings.batchDir, images, workers, key);
+	std::cerr << "batch of " << images.size() << " images in " << workers << " shards took "
+		  << std::chrono::duration<double>(Clock::now() - start).count() << " s" << std::endl;
+	return failedShards == 0 ? 0 : -1;
+}
+
+/* runBatchWorker: convert every entry of one shard that its checkpoint does not already list.
+ *	Returns 0 once the shard is complete, even if some images could not be read.
+ * int shard:			which shard to convert
+ * BatchSettings settings:	the batch directory and the conversion settings
+*/
+int runBatchWorker(int shard, BatchSettings settings) {
+	std::vector<String> entries = readLines(shardList(settings.batchDir, shard));
+	if (entries.empty()) return 0;
+	String key = settingsKey(settings);
+	std::set<int> crashed;
+	std::map<int, BatchRecord> done = readCheckpoint(settings.batchDir, shard, key, &crashed);
+
+	int checkpoint = open(shardCheckpoint(settings.batchDir, shard).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666);
+	if (checkpoint < 0) {
+		std::cerr << "Could not open the checkpoint for shard " << shard << std::endl;
+		return -1;
+	}
+
+	for (const String& entry : entries) {
+		size_t tab = entry.find('\t');
+		if (tab == String::npos) continue;
+		int index = std::stoi(entry.substr(0, tab));
+		String fileName = entry.substr(tab + 1);
+		if (done.find(index) != done.end()) continue;
+
+		bool written;
+		if (crashed.count(index)) {
+			// the last worker died on this one, so give up on it rather than dying again
+			std::cerr << fileName << " crashed a worker for shard " << shard << ", skipping it" << std::endl;
+			written = appendCheckpoint(checkpoint, index, 0, "fail", key, fileName);
+		}
+		else if (!appendCheckpoint(checkpoint, index, 0, "started", key, fileName)) {
+			written = false;
+		}
+		else {
+			Clock::time_point start = Clock::now();
+			char* result = NULL;
+			bool ok = false;
+			try {
+				if (settings.cacheDir.empty()) result = convertImage(fileName, settings.opts);
+				else result = convertImageCached(fileName, settings.opts, settings.cacheDir, settings.cacheBytes, NULL);
+				ok = (result != NULL) && writeFileAtomic(outputFile(settings.batchDir, index), result, strlen(result));
+				if (ok && !settings.previewExt.empty()) {
+					ok = writeAsciiPreview(result, outputFile(settings.batchDir, index, settings.previewExt));
+				}
+			}
+			catch (const cv::Exception&) {
+				ok = false;
+			}
+			free(result);
+			double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			// only checkpoint once the output is in place
+			written = appendCheckpoint(checkpoint, index, ms, ok ? "ok" : "fail", key, fileName);
+		}
+		if (!written) {
+			std::cerr << "Could not update the checkpoint for shard " << shard << std::endl;
+			close(checkpoint);
+			return -1;
+		}
+	}
+	close(checkpoint);
+	return 0;
+}
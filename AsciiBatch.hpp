@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include "GenerateAscii.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Converts a list of images with several worker	*/
+/*	processes, resuming from checkpoints after a crash		*/
+/************************************************************************/
+
+// constants
+const int MAX_BATCH_WORKERS	= 256;
+const int MAX_SHARD_RETRIES	= 3; // restarts allowed for a crashed worker before giving up on its shard
+
+// settings shared by the coordinator and every worker of a batch
+struct BatchSettings {
+	String batchDir;		// shard lists, checkpoints and outputs all live here
+	AsciiOptions opts;
+	String cacheDir;		// optional result cache shared by the workers
+	long cacheBytes		= 0;
+	String previewExt;		// image format for a preview of each result, e.g. ".png". Empty for none
+};
+
+// function declarations
+int runBatchCoordinator(String manifest, int workers, bool spawn, BatchSettings settings, int argc, char** argv);
+int runBatchWorker(int shard, BatchSettings settings);
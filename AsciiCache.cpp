@@ -0,0 +1,296 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include "AsciiCache.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: On-disk cache of finished ascii art, keyed by the	*/
+/*	contents of the input image and the conversion settings	*/
+/************************************************************************/
+
+// Layout of a cache directory:
+//	<key>.txt	one finished result per entry. The modification time doubles as the last use time
+//	stats		running hit and miss totals
+//	lock		flock()ed while the stats are updated or entries are evicted
+// Entries are written to a temporary file and renamed into place, so readers never need the lock.
+
+namespace fs = std::filesystem;
+
+/**************************************
+ * Helper Functions *******************
+ **************************************/
+
+/* fnvHash: 64 bit FNV-1a hash of a block of bytes, continuing from a previous hash value
+ * uint64_t hash:	the hash so far (start with FNV_OFFSET)
+ * const char* data:	the bytes to add
+ * size_t len:		the number of bytes to add
+*/
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+static uint64_t fnvHash(uint64_t hash, const char* data, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+/* optionsString: every setting that affects the result, in a fixed order. Bump the version when
+ * the output of the pipeline changes so stale entries stop matching.
+ * AsciiOptions opts:	the settings to describe
+*/
+static std::string optionsString(AsciiOptions opts) {
+	std::ostringstream out;
+	out << "v3"
+	    << " p" << opts.preProcess
+	    << " b" << opts.blurThreshold
+	    << " l" << opts.lowThreshold
+	    << " r" << opts.ratio
+	    << " k" << opts.kernelSize
+	    << " 1k" << opts.kernal1
+	    << " 2k" << opts.kernal2
+	    << " m" << opts.median
+	    << " t" << opts.threshold
+	    << " c" << opts.ascHeight
+	    << " f" << opts.fill
+	    << " o" << opts.color
+	    << " a" << opts.angles
+	    << " s" << opts.ramp.size() << ":" << opts.ramp;
+	return out.str();
+}
+
+/* lockCache: take the cache wide lock. Returns the descriptor to pass to unlockCache.
+ * String cacheDir:	the cache directory
+*/
+static int lockCache(String cacheDir) {
+	int fd = open((cacheDir + "/lock").c_str(), O_RDWR | O_CREAT, 0666);
+	if (fd >= 0) flock(fd, LOCK_EX);
+	return fd;
+}
+
+static void unlockCache(int fd) {
+	if (fd < 0) return;
+	flock(fd, LOCK_UN);
+	close(fd);
+}
+
+static AsciiCacheStats readStats(String cacheDir) {
+	AsciiCacheStats stats;
+	std::ifstream in(cacheDir + "/stats");
+	in >> stats.hits >> stats.misses;
+	return stats;
+}
+
+/* countLookup: add one hit or miss to the shared totals */
+static void countLookup(String cacheDir, bool hit) {
+	int fd = lockCache(cacheDir);
+	AsciiCacheStats stats = readStats(cacheDir);
+	if (hit) stats.hits++;
+	else stats.misses++;
+	String line = std::to_string(stats.hits) + " " + std::to_string(stats.misses) + "\n";
+	writeFileAtomic(cacheDir + "/stats", line.c_str(), line.size());
+	unlockCache(fd);
+}
+
+/* evictEntries: remove the least recently used entries until the cache fits in maxBytes.
+ * The caller must hold the cache lock.
+*/
+static void evictEntries(String cacheDir, long maxBytes) {
+	struct Entry {
+		fs::file_time_type used;
+		uintmax_t size;
+		fs::path path;
+	};
+	std::vector<Entry> entries;
+	uintmax_t total = 0;
+	std::error_code ec;
+
+	for (const fs::directory_entry& file : fs::directory_iterator(cacheDir, ec)) {
+		fs::path path = file.path();
+		if (path.extension() != ".txt" || path.filename().string()[0] == '.') continue;
+		Entry entry = { file.last_write_time(ec), file.file_size(ec), path };
+		if (ec) continue; // removed by someone else while we looked
+		total += entry.size;
+		entries.push_back(entry);
+	}
+	if (total <= (uintmax_t)maxBytes) return;
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){ return a.used < b.used; });
+	for (size_t i = 0; i < entries.size() && total > (uintmax_t)maxBytes; i++) {
+		if (fs::remove(entries[i].path, ec)) total -= entries[i].size;
+	}
+}
+
+
+/**************************************
+ * Cache Interface ********************
+ **************************************/
+
+/* cacheKey: build the key for a conversion from the bytes of the input file and the settings.
+ * Returns an empty string if the file cannot be read.
+ * String fileName:	path to the image supplied by the user
+ * AsciiOptions opts:	the settings the image will be converted with
+*/
+std::string cacheKey(String fileName, AsciiOptions opts) {
+	String path = samples::findFile(fileName, false, true);
+	if (path.empty()) return "";
+	std::ifstream in(path, std::ios::binary);
+	if (!in) return "";
+
+	// hash the contents in chunks so large images are never held in memory twice
+	uint64_t contentHash = FNV_OFFSET;
+	uint64_t size = 0;
+	std::vector<char> chunk(1 << 16);
+	while (in) {
+		in.read(chunk.data(), chunk.size());
+		contentHash = fnvHash(contentHash, chunk.data(), in.gcount());
+		size += in.gcount();
+	}
+	std::string options = optionsString(opts);
+	uint64_t optionsHash = fnvHash(FNV_OFFSET, options.c_str(), options.size());
+
+	char key[64];
+	snprintf(key, sizeof(key), "%016llx%016llx-%llx", (unsigned long long)contentHash,
+		(unsigned long long)optionsHash, (unsigned long long)size);
+	return key;
+}
+
+/* optionsKey: a short hash of every setting that affects the result, for anything else that needs to
+ *	tell whether a stored result was made with the same settings.
+ * AsciiOptions opts:	the settings to describe
+*/
+std::string optionsKey(AsciiOptions opts) {
+	std::string options = optionsString(opts);
+	char key[32];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)fnvHash(FNV_OFFSET, options.c_str(), options.size()));
+	return key;
+}
+
+/* cacheLookup: find a stored result. Returns a malloc'd copy of the ascii art (free it when done),
+ * or NULL on a miss. Either way the shared hit/miss totals are updated.
+ * String cacheDir:	the cache directory. Created if it does not exist
+ * std::string key:	the key from cacheKey
+*/
+char* cacheLookup(String cacheDir, std::string key) {
+	std::error_code ec;
+	fs::create_directories(cacheDir, ec);
+
+	String path = cacheDir + "/" + key + ".txt";
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) {
+		countLookup(cacheDir, false);
+		return NULL;
+	}
+	std::streamsize size = in.tellg();
+	in.seekg(0);
+	char* result = (char*)malloc(size + 1);
+	in.read(result, size);
+	if (in.gcount() != size) {
+		free(result);
+		countLookup(cacheDir, false);
+		return NULL;
+	}
+	result[size] = '\0';
+
+	// mark as recently used for eviction
+	fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+	countLookup(cacheDir, true);
+	return result;
+}
+
+/* cacheStore: add a result to the cache, then evict old entries if it has grown past maxBytes
+ * String cacheDir:	the cache directory
+ * std::string key:	the key from cacheKey
+ * const char* result:	the finished ascii art
+ * long maxBytes:	the size limit for all entries combined
+*/
+void cacheStore(String cacheDir, std::string key, const char* result, long maxBytes) {
+	std::error_code ec;
+	fs::create_directories(cacheDir, ec);
+	if (!writeFileAtomic(cacheDir + "/" + key + ".txt", result, strlen(result))) {
+		std::cerr << "Could not write to the cache in " << cacheDir << std::endl;
+		return;
+	}
+	int fd = lockCache(cacheDir);
+	evictEntries(cacheDir, maxBytes);
+	unlockCache(fd);
+}
+
+/* cacheStats: the hit and miss totals for every process that has used this cache
+ * String cacheDir:	the cache directory
+*/
+AsciiCacheStats cacheStats(String cacheDir) {
+	return readStats(cacheDir);
+}
+
+/* convertImageCached: convertImage, but a result already in the cache is returned without decoding the
+ *	image, and a new result is stored for next time. Returns NULL if the image could not be read.
+ * String fileName:	path to the image supplied by the user
+ * AsciiOptions opts:	the preprocess method and its parameters
+ * String cacheDir:	the cache directory
+ * long maxBytes:	the size limit for the cache
+ * bool* hit:		set to whether the result came from the cache. May be NULL
+*/
+char* convertImageCached(String fileName, AsciiOptions opts, String cacheDir, long maxBytes, bool* hit) {
+	char* result = NULL;
+	std::string key = cacheKey(fileName, opts);
+	if (!key.empty()) result = cacheLookup(cacheDir, key);
+	if (hit) *hit = (result != NULL);
+	if (result) return result;
+
+	result = convertImage(fileName, opts);
+	if (result && !key.empty()) cacheStore(cacheDir, key, result, maxBytes);
+	return result;
+}
+
+/* writeFileAtomic: write a file by way of a temporary file in the same directory and a rename,
+ *	so other processes see either the old file or the complete new one. Safe to call from several
+ *	threads at once, even for the same path.
+ * String path:		the file to write
+ * const char* data:	the contents
+ * size_t len:		the number of bytes in data
+*/
+bool writeFileAtomic(String path, const char* data, size_t len) {
+	// the counter keeps threads of one process from sharing a temporary file
+	static std::atomic<unsigned long> writes(0);
+	String temp = path + "." + std::to_string(getpid()) + "-" + std::to_string(writes++) + ".tmp";
+	std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+	if (!out) return false;
+	out.write(data, len);
+	out.close();
+	if (!out || rename(temp.c_str(), path.c_str()) != 0) {
+		unlink(temp.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include "GenerateAscii.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: On-disk cache of finished ascii art, keyed by the	*/
+/*	contents of the input image and the conversion settings	*/
+/************************************************************************/
+
+// constants
+const long DEFAULT_CACHE_SIZE_MB	= 64;
+const int MAX_CACHE_SIZE_MB		= 1 << 20;
+
+// hit and miss totals shared by every process using the same cache directory
+struct AsciiCacheStats {
+	long hits	= 0;
+	long misses	= 0;
+};
+
+// function declarations
+std::string cacheKey(String fileName, AsciiOptions opts);
+std::string optionsKey(AsciiOptions opts);
+char* cacheLookup(String cacheDir, std::string key);
+void cacheStore(String cacheDir, std::string key, const char* result, long maxBytes);
+AsciiCacheStats cacheStats(String cacheDir);
+char* convertImageCached(String fileName, AsciiOptions opts, String cacheDir, long maxBytes, bool* hit);
+bool writeFileAtomic(String path, const char* data, size_t len);
@@ -0,0 +1,324 @@
+#include "opencv2/imgproc.hpp"
+#include <iostream>
+#include <vector>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <atomic>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include "AsciiInput.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Reads uncompressed images without a decoder: raw	*/
+/*	frames from a pipe, and memory mapped PGM/PPM files		*/
+/************************************************************************/
+
+
+// Both inputs are wrapped as Mat headers over memory we already hold, with no copy: the pages of a
+// mapped file, or the buffer a raw frame was read into. Gray data goes straight to preprocessing.
+// A mapped file that is truncated while in use raises SIGBUS on the next touch of a page that is gone,
+// which would take a whole watch or batch run down with it. Every mapping is registered with a SIGBUS
+// handler that swaps the missing pages for zeros and marks the mapping, so the conversion carries on
+// and unmapImage reports it as failed. Files on a network filesystem, where another host can cut them
+// short at any time, are simply read into a buffer instead.
+
+// filesystems whose files may be truncated by another host at any time
+static const long NETWORK_FILESYSTEMS[] = {
+	0x6969,		// NFS
+	0x517B,		// SMB
+	0xFE534D42,	// SMB2
+	0xFF534D42,	// CIFS
+};
+
+// a mapping the SIGBUS handler is allowed to repair. Only atomics, so the handler can read them safely
+struct GuardedMapping {
+	std::atomic<char*> start;
+	std::atomic<size_t> length;
+	std::atomic<bool> truncated;
+};
+
+static GuardedMapping guarded[MAX_GUARDED_MAPPINGS];
+static std::mutex guardLock; // taken to claim or release a slot, never in the handler
+static struct sigaction previousBusAction;
+static size_t pageSize;
+
+/**************************************
+ * Helper Functions *******************
+ **************************************/
+
+/* netpbmNumber: read one number from a netpbm header, skipping whitespace and comments.
+ *	Returns -1 if there is no number.
+ * const char* data:	the start of the file
+ * size_t length:	the length of the file
+ * size_t& at:		where to start reading. Left just after the number
+*/
+static long netpbmNumber(const char* data, size_t length, size_t& at) {
+	while (at < length) {
+		if (data[at] == '#') {
+			while (at < length && data[at] != '\n') at++;
+		}
+		else if (isspace((unsigned char)data[at])) at++;
+		else break;
+	}
+	if (at >= length || !isdigit((unsigned char)data[at])) return -1;
+	long value = 0;
+	while (at < length && isdigit((unsigned char)data[at]) && value <= MAX_RAW_DIMENSION) {
+		value = value * 10 + (data[at] - '0');
+		at++;
+	}
+	return value;
+}
+
+/* readFully: read exactly len bytes, unless the input ends first. Returns the number of bytes read. */
+static size_t readFully(int fd, char* buffer, size_t len) {
+	size_t total = 0;
+	while (total < len) {
+		ssize_t got = read(fd, buffer + total, len - total);
+		if (got < 0 && errno == EINTR) continue;
+		if (got <= 0) break;
+		total += got;
+	}
+	return total;
+}
+
+
+/* onNetworkFilesystem: whether an open file lives on a filesystem shared with other hosts */
+static bool onNetworkFilesystem(int fd) {
+	struct statfs fileSystem;
+	if (fstatfs(fd, &fileSystem) != 0) return true;
+	for (long type : NETWORK_FILESYSTEMS) {
+		if ((long)(unsigned int)fileSystem.f_type == type) return true;
+	}
+	return false;
+}
+
+/* busHandler: SIGBUS handler. A fault inside a guarded mapping means the file shrank under us, so
+ *	the rest of the mapping is replaced with zeroed pages and the faulting access is simply retried.
+ *	Any other SIGBUS is handed back to whatever handled it before.
+*/
+static void busHandler(int signal, siginfo_t* info, void* context) {
+	char* address = (char*)info->si_addr;
+	for (int i = 0; i < MAX_GUARDED_MAPPINGS; i++) {
+		char* start = guarded[i].start.load();
+		size_t length = guarded[i].length.load();
+		if (!start || address < start || address >= start + length) continue;
+		char* from = start + ((address - start) / pageSize) * pageSize;
+		mmap(from, start + length - from, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+		guarded[i].truncated = true;
+		return;
+	}
+	// not ours. Put the old action back; returning faults again and it takes over
+	sigaction(SIGBUS, &previousBusAction, NULL);
+}
+
+/* guardMapping: register a mapping with the SIGBUS handler, installing it the first time.
+ *	Returns the slot, or -1 if every slot is taken.
+*/
+static int guardMapping(void* base, size_t length) {
+	static std::once_flag installed;
+	std::call_once(installed, []() {
+		pageSize = sysconf(_SC_PAGESIZE);
+		struct sigaction action = {};
+		action.sa_sigaction = busHandler;
+		action.sa_flags = SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGBUS, &action, &previousBusAction);
+	});
+
+	std::lock_guard<std::mutex> lock(guardLock);
+	for (int i = 0; i < MAX_GUARDED_MAPPINGS; i++) {
+		if (guarded[i].start.load()) continue;
+		guarded[i].length = length;
+		guarded[i].truncated = false;
+		guarded[i].start = (char*)base;
+		return i;
+	}
+	return -1;
+}
+
+
+/**************************************
+ * Input Interface ********************
+ **************************************/
+
+/* mapNetpbm: map a binary 8 bit PGM (P5) or PPM (P6) file into memory and wrap its pixels as a Mat.
+ *	Only the header is read to decide; files on a network filesystem are then read rather than
+ *	mapped. Returns false, leaving mapped empty, for anything else (including 16 bit files), so the
+ *	caller can fall back to imread. Release the memory with unmapImage.
+ * String fileName:	path to the image, looked up the same way as for imread
+ * MappedImage& mapped:	set to the mapping
+*/
+bool mapNetpbm(String fileName, MappedImage& mapped) {
+	String path = samples::findFile(fileName, false, true);
+	if (path.empty()) return false;
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return false;
+	struct stat info;
+	char header[MAX_NETPBM_HEADER];
+	ssize_t got = -1;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size >= 8) {
+		got = pread(fd, header, sizeof(header), 0);
+	}
+	if (got < 8) {
+		close(fd);
+		return false;
+	}
+
+	// anything that is not an 8 bit netpbm file is turned away here, before the rest of it is touched
+	int channels = (header[0] == 'P' && header[1] == '5') ? 1 : (header[0] == 'P' && header[1] == '6') ? 3 : 0;
+	size_t at = 2;
+	long width = -1, height = -1, maxValue = -1;
+	if (channels > 0) {
+		width = netpbmNumber(header, got, at);
+		height = netpbmNumber(header, got, at);
+		maxValue = netpbmNumber(header, got, at);
+	}
+	size_t length = info.st_size;
+	// exactly one whitespace character separates the header from the pixels
+	if (channels == 0 || at >= (size_t)got || !isspace((unsigned char)header[at]) || width < 1 || height < 1
+	    || width > MAX_RAW_DIMENSION || height > MAX_RAW_DIMENSION || maxValue < 1 || maxValue > 255
+	    || at + 1 + (size_t)width * height * channels > length) {
+		close(fd);
+		return false;
+	}
+	at++;
+
+	// a mapping is private and writable, so anything that writes to the Mat gets its own copy of that
+	// page and the file is never changed
+	void* base = NULL;
+	int guard = -1;
+	if (!onNetworkFilesystem(fd)) {
+		base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (base == MAP_FAILED) base = NULL;
+		else if ((guard = guardMapping(base, length)) < 0) {
+			munmap(base, length);
+			base = NULL;
+		}
+	}
+	if (!base) {
+		base = malloc(length);
+		if (base && readFully(fd, (char*)base, length) != length) {
+			// cut short while we read it
+			free(base);
+			base = NULL;
+		}
+	}
+	close(fd);
+	if (!base) return false;
+
+	if (guard >= 0) madvise(base, length, MADV_SEQUENTIAL);
+	mapped.base = base;
+	mapped.length = length;
+	mapped.guard = guard;
+	mapped.image = Mat(height, width, channels == 1 ? CV_8UC1 : CV_8UC3, (char*)base + at);
+	return true;
+}
+
+/* mappedGray: a grayscale view of a mapped image. A PGM is used in place, a PPM needs converting */
+Mat mappedGray(const MappedImage& mapped) {
+	if (mapped.image.empty() || mapped.image.channels() == 1) return mapped.image;
+	Mat srcGray;
+	cvtColor(mapped.image, srcGray, COLOR_RGB2GRAY);
+	return srcGray;
+}
+
+/* unmapImage: release the memory from mapNetpbm. Safe to call on an empty MappedImage.
+ *	Returns false if the file was cut short while it was mapped, in which case part of the image
+ *	read as zeros and anything made from it should be thrown away.
+*/
+bool unmapImage(MappedImage& mapped) {
+	bool intact = true;
+	mapped.image = Mat();
+	if (mapped.guard >= 0) {
+		{
+			std::lock_guard<std::mutex> lock(guardLock);
+			intact = !guarded[mapped.guard].truncated.load();
+			guarded[mapped.guard].start = NULL;
+		}
+		munmap(mapped.base, mapped.length);
+	}
+	else free(mapped.base);
+	mapped.base = NULL;
+	mapped.length = 0;
+	mapped.guard = -1;
+	return intact;
+}
+
+/* convertRawFrames: convert a stream of raw 8 bit frames, such as "ffmpeg -f rawvideo -pix_fmt gray",
+ *	printing the ascii art for each one as it arrives. Returns 0 once the input ends.
+ * String source:	"-" for stdin, or the path to a FIFO or file
+ * int width:		frame width in pixels
+ * int height:		frame height in pixels
+ * int channels:	1 for gray frames, 3 for BGR frames (-pix_fmt bgr24)
+ * AsciiOptions opts:	the preprocess method and its parameters
+*/
+int convertRawFrames(String source, int width, int height, int channels, AsciiOptions opts) {
+	int fd = (source == "-") ? STDIN_FILENO : open(source.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		std::cout << "Could not open " << source << std::endl;
+		return -1;
+	}
+
+	// one buffer for the whole run. Each frame is read into it and wrapped in place
+	size_t frameSize = (size_t)width * height * channels;
+	std::vector<char> buffer(frameSize);
+	Mat frame(height, width, channels == 1 ? CV_8UC1 : CV_8UC3, buffer.data());
+	Mat srcGray;
+	long frames = 0;
+
+	for (;;) {
+		size_t got = readFully(fd, buffer.data(), frameSize);
+		if (got == 0) break;
+		if (got < frameSize) {
+			std::cerr << "the input ended part way through frame " << frames << std::endl;
+			break;
+		}
+		if (channels == 1) srcGray = frame;
+		else cvtColor(frame, srcGray, COLOR_BGR2GRAY);
+
+		char* result = convertGrayImage(srcGray, opts);
+		if (result && opts.color) {
+			char* colored = colorizeAscii(result, frame, opts.color, opts.preProcess == 2 ? Size() : srcGray.size());
+			free(result);
+			result = colored;
+		}
+		if (result) {
+			fputs(result, stdout);
+			fputs("\n\n", stdout);
+			fflush(stdout);
+			free(result);
+		}
+		frames++;
+	}
+
+	if (fd != STDIN_FILENO) close(fd);
+	return frames > 0 ? 0 : -1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include "GenerateAscii.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Reads uncompressed images without a decoder: raw	*/
+/*	frames from a pipe, and memory mapped PGM/PPM files		*/
+/************************************************************************/
+
+// constants
+const int MAX_RAW_DIMENSION	= 1 << 16;
+const int MAX_NETPBM_HEADER	= 4096; // longest PGM/PPM header (with comments) that is recognised
+const int MAX_GUARDED_MAPPINGS	= 64; // mappings open at once. Any more are read instead
+
+// a PGM or PPM file mapped (or, on a network filesystem, read) into memory. image points straight into it
+struct MappedImage {
+	void* base		= NULL;
+	size_t length		= 0;
+	int guard		= -1;	// slot watched by the SIGBUS handler, or -1 if base came from malloc
+	Mat image;		// CV_8UC1 for PGM, CV_8UC3 (RGB order) for PPM
+};
+
+// function declarations
+bool mapNetpbm(String fileName, MappedImage& mapped);
+Mat mappedGray(const MappedImage& mapped);
+bool unmapImage(MappedImage& mapped);
+int convertRawFrames(String source, int width, int height, int channels, AsciiOptions opts);
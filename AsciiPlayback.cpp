@@ -0,0 +1,208 @@
+#include "opencv2/imgproc.hpp"
+#include "opencv2/videoio.hpp"
+#include <iostream>
+#include <cstdio>
+#include <cmath>
+#include <cctype>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "AsciiPlayback.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Plays video or a live camera as ascii art, trading	*/
+/*	quality for speed to hold a target frame time			*/
+/************************************************************************/
+
+
+// The governor measures every frame and moves along the quality ladder to hold the target frame time.
+// It steps down quickly when frames run long, but only steps back up after a long run of frames with
+// plenty of headroom, so the picture does not flicker between two levels. A step up that has to be
+// undone straight away makes the next try at that level wait twice as long.
+
+typedef std::chrono::steady_clock Clock;
+
+// cheapest last. Resolution goes first since it speeds up every stage, the ascii height goes last
+// since it is what the viewer notices most
+static const QualityLevel QUALITY_LADDER[] = {
+	{ 1.00, 0, 1.00 },
+	{ 0.75, 0, 1.00 },
+	{ 0.50, 1, 1.00 },
+	{ 0.50, 1, 0.75 },
+	{ 0.35, 2, 0.75 },
+	{ 0.25, 2, 0.50 },
+};
+
+// hysteresis settings
+const double EMA_WEIGHT		= 0.2;	// weight of the newest frame in the moving average
+const double PANIC_RATIO	= 1.5;	// frames this far over the target...
+const int PANIC_FRAMES_TO_DROP	= 2;	// ...step down after this many in a row, one slow frame is not enough
+const int SLOW_FRAMES_TO_DROP	= 3;	// frames over target before stepping down
+const double HEADROOM_RATIO	= 0.6;	// the average must be under this fraction of the target...
+const int FAST_FRAMES_TO_RAISE	= 30;	// ...for this many frames before stepping up
+const int RAISE_PROBATION	= 30;	// a step down this soon after a step up means the raise failed
+const int MAX_FRAMES_TO_RAISE	= 960;	// cap on the backed off wait, about half a minute at 30 fps
+
+static double elapsedMs(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**************************************
+ * Quality Governor *******************
+ **************************************/
+
+int qualityLevelCount() {
+	return sizeof(QUALITY_LADDER) / sizeof(QUALITY_LADDER[0]);
+}
+
+QualityLevel qualityLevel(int level) {
+	return QUALITY_LADDER[std::min(std::max(level, 0), qualityLevelCount() - 1)];
+}
+
+/* levelOptions: adjust the conversion settings for a quality level. Blur and kernel sizes are in
+ *	pixels, so they shrink along with the processing resolution to keep the same look.
+ * AsciiOptions opts:	the settings requested by the user
+ * QualityLevel level:	the operating point to adjust them for
+*/
+AsciiOptions levelOptions(AsciiOptions opts, QualityLevel level) {
+	opts.ascHeight = std::max(1, (int)std::lround(opts.ascHeight * level.heightScale));
+	opts.blurThreshold = std::max(1, (int)std::lround(opts.blurThreshold * level.scale));
+	opts.kernelSize = std::max(3, opts.kernelSize - 2 * level.kernelShrink);
+	opts.kernal1 = std::max(1, (int)std::lround(opts.kernal1 * level.scale));
+	opts.kernal2 = std::max(1, (int)std::lround(opts.kernal2 * level.scale));
+	opts.median = std::max(1, (int)std::lround(opts.median * level.scale));
+	return opts;
+}
+
+/* governorUpdate: record the time a frame took and pick the quality level for the next one
+ * QualityGovernor& gov:	the governor state
+ * double frameMs:		how long the last frame took, from capture to output
+*/
+void governorUpdate(QualityGovernor& gov, double frameMs) {
+	gov.frames++;
+	if (frameMs > gov.targetMs) gov.missedDeadlines++;
+	gov.averageMs = (gov.frames == 1) ? frameMs : EMA_WEIGHT * frameMs + (1 - EMA_WEIGHT) * gov.averageMs;
+
+	if (gov.raiseAfter.empty()) gov.raiseAfter.assign(qualityLevelCount(), FAST_FRAMES_TO_RAISE);
+
+	if (gov.averageMs > gov.targetMs) gov.slowFrames++;
+	else gov.slowFrames = 0;
+	if (gov.averageMs < HEADROOM_RATIO * gov.targetMs) gov.fastFrames++;
+	else gov.fastFrames = 0;
+	if (frameMs > PANIC_RATIO * gov.targetMs) gov.panicFrames++;
+	else gov.panicFrames = 0;
+
+	int next = gov.level;
+	if (gov.panicFrames >= PANIC_FRAMES_TO_DROP || gov.slowFrames >= SLOW_FRAMES_TO_DROP) next++;
+	else if (gov.level > 0 && gov.fastFrames >= gov.raiseAfter[gov.level - 1]) next--;
+	next = std::min(std::max(next, 0), qualityLevelCount() - 1);
+
+	if (next > gov.level && gov.raisedAt >= 0 && gov.frames - gov.raisedAt <= RAISE_PROBATION) {
+		// this level could not be held, so wait longer before trying it again
+		gov.raiseAfter[gov.level] = std::min(2 * gov.raiseAfter[gov.level], MAX_FRAMES_TO_RAISE);
+	}
+	if (next != gov.level) {
+		gov.raisedAt = (next < gov.level) ? gov.frames : -1;
+		gov.level = next;
+		gov.panicFrames = 0;
+		gov.slowFrames = 0;
+		gov.fastFrames = 0;
+		// start the average over at the new level, so old frames don't trigger a second change
+		gov.averageMs = gov.targetMs * (HEADROOM_RATIO + 1) / 2;
+	}
+}
+
+
+/**************************************
+ * Playback ***************************
+ **************************************/
+
+/* playVideo: play a video file or camera as ascii art in the terminal, holding frameMs per frame.
+ *	Each frame is drawn over the last, with a status line showing the governor's counters.
+ *	Returns false if the source could not be opened.
+ * String source:	path to a video file, or the number of a camera
+ * AsciiOptions opts:	the preprocess method and its parameters at full quality
+ * int frameMs:		the target time for each frame in milliseconds
+*/
+bool playVideo(String source, AsciiOptions opts, int frameMs) {
+	VideoCapture capture;
+	bool isCamera = !source.empty() && std::all_of(source.begin(), source.end(), ::isdigit);
+	if (isCamera) capture.open(std::stoi(source));
+	else capture.open(source);
+	if (!capture.isOpened()) {
+		std::cout << "Could not open the video " << source << std::endl;
+		return false;
+	}
+
+	QualityGovernor gov;
+	gov.targetMs = frameMs;
+	setvbuf(stdout, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+	fputs("\x1b[2J", stdout); // clear the screen once. Later frames just draw over the top
+
+	Mat frame, srcGray, scaled;
+	Clock::time_point frameStart = Clock::now();
+	while (capture.read(frame)) {
+		QualityLevel level = qualityLevel(gov.level);
+		AsciiOptions levelOpts = levelOptions(opts, level);
+
+		// preprocess at the level's resolution
+		cvtColor(frame, srcGray, COLOR_BGR2GRAY);
+		if (level.scale < 1.0) resize(srcGray, scaled, Size(), level.scale, level.scale, INTER_AREA);
+		else scaled = srcGray;
+		Mat detectedEdges = preprocessImage(scaled, levelOpts);
+		Clock::time_point preprocessed = Clock::now();
+
+		char* result = edgesToAscii(detectedEdges, levelOpts);
+		if (levelOpts.fill && levelOpts.preProcess != 2) shadeFill(result, fillGlyphs(scaled, levelOpts.ascHeight, levelOpts.ramp));
+		if (levelOpts.color) {
+			char* colored = colorizeAscii(result, frame, levelOpts.color, levelOpts.preProcess == 2 ? Size() : scaled.size());
+			free(result);
+			result = colored;
+		}
+		Clock::time_point converted = Clock::now();
+
+		// home the cursor, draw, and clear whatever is left of a taller previous frame
+		fputs("\x1b[H", stdout);
+		fputs(result, stdout);
+		fprintf(stdout, "\n\x1b[Jlevel %d/%d  scale %.2f  height %d  frame %.1f/%.0f ms (pre %.1f, ascii %.1f, out %.1f)  missed %ld/%ld\n",
+			gov.level, qualityLevelCount() - 1, level.scale, levelOpts.ascHeight, gov.averageMs, gov.targetMs,
+			gov.preprocessMs, gov.asciiMs, gov.outputMs, gov.missedDeadlines, gov.frames);
+		fflush(stdout);
+		free(result);
+		Clock::time_point written = Clock::now();
+
+		gov.preprocessMs = elapsedMs(frameStart, preprocessed);
+		gov.asciiMs = elapsedMs(preprocessed, converted);
+		gov.outputMs = elapsedMs(converted, written);
+		governorUpdate(gov, elapsedMs(frameStart, written));
+
+		// files would otherwise play as fast as they decode. Cameras already deliver at their own rate
+		if (!isCamera) std::this_thread::sleep_until(frameStart + std::chrono::milliseconds(frameMs));
+		frameStart = Clock::now();
+	}
+
+	std::cerr << "played " << gov.frames << " frames, missed " << gov.missedDeadlines
+		  << " deadlines, finished at quality level " << gov.level << std::endl;
+	return true;
+}
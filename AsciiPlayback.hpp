@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "GenerateAscii.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Plays video or a live camera as ascii art, trading	*/
+/*	quality for speed to hold a target frame time			*/
+/************************************************************************/
+
+// constants
+const int DEFAULT_FRAME_MS	= 33; // about 30 frames per second
+const int MAX_FRAME_MS		= 10000;
+
+// one step on the quality ladder. Level 0 is full quality, each later level is cheaper
+struct QualityLevel {
+	double scale;		// processing resolution, as a fraction of the source
+	int kernelShrink;	// how many steps to shrink the canny aperture
+	double heightScale;	// fraction of the requested ascii height
+};
+
+// state of the governor that picks a quality level for each frame
+struct QualityGovernor {
+	double targetMs		= DEFAULT_FRAME_MS;
+	int level		= 0;	// current operating point, an index into the quality ladder
+	double averageMs	= 0;	// moving average of the frame time
+	int slowFrames		= 0;	// consecutive frames with the average over the target
+	int fastFrames		= 0;	// consecutive frames with plenty of headroom
+	int panicFrames		= 0;	// consecutive frames far over the target
+	std::vector<int> raiseAfter;	// fast frames needed to step up into each level, grows after failed raises
+	long raisedAt		= -1;	// frame of the last step up, to spot a raise that is undone right away
+	long frames		= 0;
+	long missedDeadlines	= 0;
+	// stage latencies of the last frame
+	double preprocessMs	= 0;
+	double asciiMs		= 0;
+	double outputMs		= 0;
+};
+
+// function declarations
+int qualityLevelCount();
+QualityLevel qualityLevel(int level);
+AsciiOptions levelOptions(AsciiOptions opts, QualityLevel level);
+void governorUpdate(QualityGovernor& gov, double frameMs);
+bool playVideo(String source, AsciiOptions opts, int frameMs);
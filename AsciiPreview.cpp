@@ -0,0 +1,165 @@
+#include "opencv2/imgproc.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "AsciiPreview.hpp"
+#include "AsciiCache.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Draws finished ascii art into an image, for previews	*/
+/************************************************************************/
+
+
+// The glyphs come from OpenCV's built in Hershey font. They are drawn once into an atlas, after which
+// drawing a character is just a memcpy per pixel row of its cell.
+
+/**************************************
+ * Helper Functions *******************
+ **************************************/
+
+static int previewCellHeight() {
+	return (int)std::lround(PREVIEW_CELL_WIDTH * LEN_WID_RATIO);
+}
+
+/* buildGlyphAtlas: draw every printable character, dark on white, into a column of cells.
+ *	Cell g holds character FIRST_GLYPH + g in rows [g * cellHeight, (g + 1) * cellHeight), so each
+ *	row of a glyph is a contiguous run of PREVIEW_CELL_WIDTH bytes.
+*/
+static Mat buildGlyphAtlas() {
+	int cellWidth = PREVIEW_CELL_WIDTH;
+	int cellHeight = previewCellHeight();
+	int glyphCount = LAST_GLYPH - FIRST_GLYPH + 1;
+	Mat atlas(glyphCount * cellHeight, cellWidth, CV_8U, Scalar(255));
+
+	// scale the font so the widest character just fits across a cell, leaving room below for descenders
+	int baseline = 0;
+	Size widest = getTextSize("W", FONT_HERSHEY_PLAIN, 1.0, 1, &baseline);
+	double scale = std::min((double)(cellWidth - 1) / widest.width, (cellHeight * 0.6) / widest.height);
+	int baselineY = (int)(cellHeight * 0.75);
+
+	for (int g = 0; g < glyphCount; g++) {
+		char text[2] = { (char)(FIRST_GLYPH + g), '\0' };
+		Size size = getTextSize(text, FONT_HERSHEY_PLAIN, scale, 1, &baseline);
+		Mat cell = atlas(Rect(0, g * cellHeight, cellWidth, cellHeight));
+		putText(cell, text, Point((cellWidth - size.width) / 2, baselineY), FONT_HERSHEY_PLAIN, scale, Scalar(0), 1, LINE_AA);
+	}
+	return atlas;
+}
+
+/* skipEscape: step over an ANSI color escape sequence, such as those from colorizeAscii. Returns a
+ *	pointer to its final 'm', or to the end of the string if it is cut short.
+*/
+static const char* skipEscape(const char* c) {
+	while (*c != '\0' && *c != 'm') c++;
+	return c;
+}
+
+/* glyphAtlas: the atlas, built the first time it is needed and shared after that */
+static const Mat& glyphAtlas() {
+	static const Mat atlas = buildGlyphAtlas();
+	return atlas;
+}
+
+
+/**************************************
+ * Preview Rendering ******************
+ **************************************/
+
+/* renderAsciiPreview: draw ascii art into a grayscale image, one cell per character
+ * const char* ascArt:	the ascii art, with rows separated by '\n'
+*/
+Mat renderAsciiPreview(const char* ascArt) {
+	const Mat& atlas = glyphAtlas();
+	int cellWidth = PREVIEW_CELL_WIDTH;
+	int cellHeight = previewCellHeight();
+
+	// find the size of the grid
+	int rows = 0, cols = 0, len = 0;
+	for (const char* c = ascArt; ; c++) {
+		if (*c == '\x1b') {
+			c = skipEscape(c);
+			if (*c != '\0') continue;
+		}
+		if (*c == '\n' || *c == '\0') {
+			cols = std::max(cols, len);
+			if (len > 0 || *c == '\n') rows++;
+			len = 0;
+			if (*c == '\0') break;
+		}
+		else len++;
+	}
+	if (rows == 0 || cols == 0) return Mat();
+
+	Mat preview(rows * cellHeight, cols * cellWidth, CV_8U, Scalar(255));
+	int x = 0, y = 0;
+	for (const char* c = ascArt; *c != '\0'; c++) {
+		if (*c == '\x1b') {
+			c = skipEscape(c);
+			if (*c == '\0') break;
+			continue;
+		}
+		if (*c == '\n') {
+			x = 0;
+			y++;
+			continue;
+		}
+		// the background is already white, so spaces cost nothing
+		if (*c != ' ') {
+			char glyph = (*c >= FIRST_GLYPH && *c <= LAST_GLYPH) ? *c : '?';
+			int atlasRow = (glyph - FIRST_GLYPH) * cellHeight;
+			for (int r = 0; r < cellHeight; r++) {
+				memcpy(preview.ptr<uchar>(y * cellHeight + r) + x * cellWidth, atlas.ptr<uchar>(atlasRow + r), cellWidth);
+			}
+		}
+		x++;
+	}
+	return preview;
+}
+
+/* writeAsciiPreview: draw ascii art into an image file. The format follows the extension. The file
+ *	is written with a rename, so anything watching for it never sees half an image.
+ *	Returns false if there was nothing to draw or the file could not be written.
+ * const char* ascArt:	the ascii art, with rows separated by '\n'
+ * String fileName:	where to write the image
+*/
+bool writeAsciiPreview(const char* ascArt, String fileName) {
+	Mat preview = renderAsciiPreview(ascArt);
+	if (preview.empty()) return false;
+	std::vector<uchar> encoded;
+	if (!imencode(previewExtension(fileName), preview, encoded)) return false;
+	return writeFileAtomic(fileName, (const char*)encoded.data(), encoded.size());
+}
+
+/* previewExtension: the image format to use for previews, as an extension with its dot. Modes that
+ *	write many results take just the format ("png") as well as a file name ("preview.png").
+ * String preview:	the --preview argument
+*/
+String previewExtension(String preview) {
+	size_t dot = preview.find_last_of('.');
+	size_t slash = preview.find_last_of('/');
+	if (dot == String::npos || (slash != String::npos && dot < slash)) return "." + preview;
+	return preview.substr(dot);
+}
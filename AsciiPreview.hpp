@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include "opencv2/imgproc.hpp"
+#include "GenerateAscii.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Draws finished ascii art into an image, for previews	*/
+/************************************************************************/
+
+// constants
+const int PREVIEW_CELL_WIDTH	= 10; // pixels per character across. The height follows LEN_WID_RATIO
+const char FIRST_GLYPH		= ' ';
+const char LAST_GLYPH		= '~';
+
+// function declarations
+Mat renderAsciiPreview(const char* ascArt);
+bool writeAsciiPreview(const char* ascArt, String fileName);
+String previewExtension(String preview);
@@ -0,0 +1,148 @@
+#include "opencv2/imgproc.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include "AsciiProgressive.hpp"
+#include "AsciiPlayback.hpp"
+#include "AsciiInput.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Shows a rough result right away, then sharper ones	*/
+/*	as higher resolution passes finish				*/
+/************************************************************************/
+
+
+// Two things run at once. The first pass decodes the image at an eighth of its size, which JPEG can do
+// far faster than a full decode, and converts that. Meanwhile a second thread decodes the full image
+// and converts it at a quarter, a half, and finally full resolution, each level shrunk from the one
+// above it. Every pass uses the same ascii height, so each result can be drawn over the last one.
+// A pass is only shown if it is sharper than whatever is already showing.
+
+// results are separated by a form feed when the output is not a terminal, so readers can split them
+const char PASS_SEPARATOR = '\f';
+// the smallest image, in pixels across, worth converting as a rough pass
+const int MIN_PASS_SIZE = 16;
+
+// what has been shown so far, shared by both threads
+struct ProgressiveOutput {
+	FILE* out;
+	bool isTerminal;
+	std::mutex lock;
+	double shownScale	= 0;	// resolution of the pass on screen, 0 for none yet
+	int shownRows		= 0;	// how many lines it took up
+};
+
+/**************************************
+ * Helper Functions *******************
+ **************************************/
+
+/* convertPass: convert one pass, with blur and kernel sizes shrunk to match its resolution.
+ *	Returns NULL without doing any work if a sharper pass is already showing.
+*/
+static char* convertPass(ProgressiveOutput& output, Mat srcGray, AsciiOptions opts, double scale) {
+	{
+		std::lock_guard<std::mutex> guard(output.lock);
+		if (output.shownScale >= scale) return NULL;
+	}
+	QualityLevel level = { scale, 0, 1.0 };
+	return convertGrayImage(srcGray, levelOptions(opts, level));
+}
+
+/* showPass: draw a finished pass over the one showing, unless a sharper pass beat it there.
+ *	Takes ownership of result.
+*/
+static void showPass(ProgressiveOutput& output, char* result, double scale) {
+	if (!result) return;
+	std::lock_guard<std::mutex> guard(output.lock);
+	if (scale > output.shownScale) {
+		if (output.isTerminal && output.shownRows > 0) {
+			// back up to the first line of the last pass and clear everything below
+			fprintf(output.out, "\x1b[%dF\x1b[J", output.shownRows);
+		}
+		else if (output.shownRows > 0) {
+			fputc(PASS_SEPARATOR, output.out);
+			fputc('\n', output.out);
+		}
+		fputs(result, output.out);
+		fputc('\n', output.out);
+		fflush(output.out);
+
+		output.shownScale = scale;
+		output.shownRows = 1;
+		for (const char* c = result; *c; c++) {
+			if (*c == '\n') output.shownRows++;
+		}
+	}
+	free(result);
+}
+
+
+/**************************************
+ * Progressive Interface **************
+ **************************************/
+
+/* progressiveImage: convert an image in passes of increasing resolution, writing each to out as soon
+ *	as it is ready. On a terminal each pass replaces the one before. Returns false if the image
+ *	could not be read.
+ * String fileName:	path to the image supplied by the user
+ * AsciiOptions opts:	the preprocess method and its parameters, for the full resolution pass
+ * FILE* out:		where to write the passes
+*/
+bool progressiveImage(String fileName, AsciiOptions opts, FILE* out) {
+	ProgressiveOutput output;
+	output.out = out;
+	output.isTerminal = isatty(fileno(out));
+	bool loaded = false;
+
+	// the full decode and the passes built from it
+	std::thread fine([&]() {
+		MappedImage mapped;
+		Mat full = mapNetpbm(fileName, mapped) ? mappedGray(mapped) : loadGrayImage(fileName);
+		if (full.empty()) return;
+		loaded = true;
+
+		// each level is shrunk from the one above, not from the full image again. Images too small
+		// to shrink are quick enough to go straight to full resolution
+		if (std::min(full.rows, full.cols) >= MIN_PASS_SIZE * 4) {
+			Mat half, quarter;
+			resize(full, half, Size(), 0.5, 0.5, INTER_AREA);
+			resize(half, quarter, Size(), 0.5, 0.5, INTER_AREA);
+			showPass(output, convertPass(output, quarter, opts, 0.25), 0.25);
+			showPass(output, convertPass(output, half, opts, 0.5), 0.5);
+		}
+		showPass(output, convertPass(output, full, opts, 1.0), 1.0);
+		if (!unmapImage(mapped)) std::cerr << fileName << " was cut short while it was being read" << std::endl;
+	});
+
+	// the coarse pass, straight from a reduced decode
+	Mat coarse = imread(samples::findFile(fileName, false, true), IMREAD_REDUCED_GRAYSCALE_8);
+	if (std::min(coarse.rows, coarse.cols) >= MIN_PASS_SIZE) showPass(output, convertPass(output, coarse, opts, 0.125), 0.125);
+
+	fine.join();
+	return loaded;
+}
@@ -0,0 +1,136 @@
+#include "opencv2/imgproc.hpp"
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "AsciiTiles.hpp"
+#include "AsciiCache.hpp"
+#include "AsciiInput.hpp"
+#include "AsciiPreview.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Converts every tile of a sprite or contact sheet,	*/
+/*	decoding and preprocessing the sheet only once			*/
+/************************************************************************/
+
+
+// The whole sheet is decoded and preprocessed once. Each tile is then just a Mat header pointing into
+// the preprocessed sheet (no pixels are copied), which is handed to the usual ascii conversion. The
+// tiles are independent, so they are converted in parallel.
+
+namespace fs = std::filesystem;
+
+/* previewName: where the preview of tile i goes. Next to its text in the output directory, or named
+ *	after the --preview file when the tiles are printed.
+*/
+static String previewName(String outputDir, String preview, int i) {
+	char index[32];
+	String extension = previewExtension(preview);
+	if (!outputDir.empty()) {
+		snprintf(index, sizeof(index), "/tile_%05d", i);
+		return outputDir + index + extension;
+	}
+	snprintf(index, sizeof(index), "_%05d", i);
+	String stem = preview.size() > extension.size() ? preview.substr(0, preview.size() - extension.size()) : "tile";
+	return stem + index + extension;
+}
+
+/* convertTiles: convert every tile of a sheet to ascii. With an output directory each tile is written
+ *	to tile_<index>.txt there; otherwise all of them are printed as one bundle, each headed by its
+ *	index, row and column. Returns 0 on success.
+ * String fileName:	path to the sheet
+ * TileGeometry tiles:	the size and spacing of the tiles
+ * AsciiOptions opts:	the preprocess method and its parameters. The ascii height is per tile
+ * String outputDir:	where to write the tiles, or empty to print them
+ * String preview:	the --preview argument, to draw a preview of each tile as well. Empty for none
+*/
+int convertTiles(String fileName, TileGeometry tiles, AsciiOptions opts, String outputDir, String preview) {
+	MappedImage mapped;
+	Mat src, srcGray;
+	if (mapNetpbm(fileName, mapped)) {
+		srcGray = mappedGray(mapped);
+		if (opts.color && mapped.image.channels() == 3) cvtColor(mapped.image, src, COLOR_RGB2BGR);
+		else src = mapped.image;
+	}
+	else {
+		src = loadColorImage(fileName);
+		if (!src.empty()) cvtColor(src, srcGray, COLOR_BGR2GRAY);
+	}
+	if (srcGray.empty()) return -1;
+
+	int cols = (srcGray.cols - 2 * tiles.margin + tiles.spacing) / (tiles.width + tiles.spacing);
+	int rows = (srcGray.rows - 2 * tiles.margin + tiles.spacing) / (tiles.height + tiles.spacing);
+	if (cols < 1 || rows < 1) {
+		std::cout << "The sheet is smaller than one " << tiles.width << "x" << tiles.height << " tile" << std::endl;
+		unmapImage(mapped);
+		return -1;
+	}
+
+	// the expensive part, once for the whole sheet
+	Mat detectedEdges = preprocessImage(srcGray, opts);
+
+	std::vector<char*> results(rows * cols, NULL);
+	parallel_for_(Range(0, rows * cols), [&](const Range& range) {
+		for (int i = range.start; i < range.end; i++) {
+			Rect tile(tiles.margin + (i % cols) * (tiles.width + tiles.spacing),
+				  tiles.margin + (i / cols) * (tiles.height + tiles.spacing), tiles.width, tiles.height);
+			char* result = edgesToAscii(detectedEdges(tile), opts);
+			if (result && opts.fill && opts.preProcess != 2) shadeFill(result, fillGlyphs(srcGray(tile), opts.ascHeight, opts.ramp));
+			if (result && opts.color) {
+				char* colored = colorizeAscii(result, src(tile), opts.color, opts.preProcess == 2 ? Size() : tile.size());
+				free(result);
+				result = colored;
+			}
+			results[i] = result;
+		}
+	});
+	if (!unmapImage(mapped)) {
+		std::cout << fileName << " was cut short while it was being read" << std::endl;
+		for (char* result : results) free(result);
+		return -1;
+	}
+
+	int failed = 0;
+	std::error_code ec;
+	if (!outputDir.empty()) fs::create_directories(outputDir, ec);
+	for (int i = 0; i < rows * cols; i++) {
+		if (!results[i]) {
+			failed++;
+			continue;
+		}
+		if (!outputDir.empty()) {
+			char name[32];
+			snprintf(name, sizeof(name), "/tile_%05d.txt", i);
+			if (!writeFileAtomic(outputDir + name, results[i], strlen(results[i]))) failed++;
+		}
+		else {
+			printf("==> tile %d row %d col %d <==\n%s\n\n", i, i / cols, i % cols, results[i]);
+		}
+		if (!preview.empty() && !writeAsciiPreview(results[i], previewName(outputDir, preview, i))) failed++;
+		free(results[i]);
+	}
+	std::cerr << rows * cols << " tiles (" << rows << " rows of " << cols << ")" << std::endl;
+	return failed == 0 ? 0 : -1;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include "GenerateAscii.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Converts every tile of a sprite or contact sheet,	*/
+/*	decoding and preprocessing the sheet only once			*/
+/************************************************************************/
+
+// constants
+const int MAX_TILE_SPACING	= 1 << 12;
+
+// where the tiles sit on the sheet, in pixels. Tiles are read left to right, then top to bottom
+struct TileGeometry {
+	int width	= 0;
+	int height	= 0;
+	int spacing	= 0;	// gap between neighbouring tiles
+	int margin	= 0;	// gap between the edge of the sheet and the first tiles
+};
+
+// function declarations
+int convertTiles(String fileName, TileGeometry tiles, AsciiOptions opts, String outputDir, String preview);
@@ -0,0 +1,248 @@
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include "AsciiWatch.hpp"
+#include "AsciiCache.hpp"
+#include "AsciiPreview.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Watches a spool directory and converts each image	*/
+/*	as soon as it has been completely written			*/
+/************************************************************************/
+
+
+// inotify reports a file once it has been closed after writing, or renamed into the directory, so an
+// image is never read half written. Each arrival is queued for a pool of threads that stay alive for
+// the whole run. A result goes to "<output dir>/<image name>.txt", written with a rename as well, and
+// its preview (if asked for) to "<output dir>/<image name>.png" or whichever format was asked for.
+
+namespace fs = std::filesystem;
+typedef std::chrono::steady_clock Clock;
+
+// an image waiting to be converted
+struct WatchJob {
+	String path;
+	String name;
+	Clock::time_point arrived;
+};
+
+// the queue shared by the watcher and the conversion threads. An image is never queued twice, or
+// converted by two threads at once; one that arrives again mid conversion is redone afterwards
+struct WatchQueue {
+	std::queue<WatchJob> jobs;
+	std::set<String> queued;	// names waiting in jobs
+	std::set<String> running;	// names being converted
+	std::set<String> again;		// names that arrived again while being converted
+	std::mutex lock;
+	std::condition_variable ready;
+};
+
+static std::mutex logLock; // keeps report lines from different threads whole
+
+/**************************************
+ * Helper Functions *******************
+ **************************************/
+
+/* isWatchedFile: whether a file in the spool should be converted. Hidden files, temporary files and
+ *	our own results and previews (which may be written into the same directory) are left alone.
+*/
+static bool isWatchedFile(const WatchSettings& settings, String name) {
+	if (name.empty() || name[0] == '.') return false;
+	String extension = fs::path(name).extension().string();
+	if (extension == ".txt" || extension == ".tmp") return false;
+
+	// a preview is named after the image it was drawn from, which is still in the directory
+	const String& preview = settings.previewExt;
+	if (settings.outputDir.empty() && !preview.empty() && name.size() > preview.size()
+	    && name.compare(name.size() - preview.size(), preview.size(), preview) == 0) {
+		std::error_code ec;
+		return !fs::is_regular_file(settings.watchDir + "/" + name.substr(0, name.size() - preview.size()), ec);
+	}
+	return true;
+}
+
+static String resultPath(const WatchSettings& settings, String name, String extension = ".txt") {
+	String dir = settings.outputDir.empty() ? settings.watchDir : settings.outputDir;
+	return dir + "/" + name + extension;
+}
+
+/* pushJob: queue an image unless it is already waiting. The caller must hold the queue lock. */
+static void pushJob(WatchQueue& queue, String path, String name) {
+	if (!queue.queued.insert(name).second) return;
+	queue.jobs.push({ path, name, Clock::now() });
+	queue.ready.notify_one();
+}
+
+static void enqueue(WatchQueue& queue, String path, String name) {
+	std::lock_guard<std::mutex> guard(queue.lock);
+	pushJob(queue, path, name);
+}
+
+/* convertJobs: body of each conversion thread. Takes images off the queue forever. */
+static void convertJobs(WatchQueue* queue, const WatchSettings* settings) {
+	for (;;) {
+		WatchJob job;
+		{
+			std::unique_lock<std::mutex> guard(queue->lock);
+			queue->ready.wait(guard, [queue]{ return !queue->jobs.empty(); });
+			job = queue->jobs.front();
+			queue->jobs.pop();
+			queue->queued.erase(job.name);
+			if (!queue->running.insert(job.name).second) {
+				// another thread has it, and will convert it again once it is done
+				queue->again.insert(job.name);
+				continue;
+			}
+		}
+		Clock::time_point started = Clock::now();
+
+		// an exception escaping a pool thread would end the whole process, so an image OpenCV chokes
+		// on is just reported like any other that could not be converted
+		char* result = NULL;
+		String output = resultPath(*settings, job.name);
+		bool ok = false;
+		try {
+			if (settings->cacheDir.empty()) result = convertImage(job.path, settings->opts);
+			else result = convertImageCached(job.path, settings->opts, settings->cacheDir, settings->cacheBytes, NULL);
+			ok = (result != NULL) && writeFileAtomic(output, result, strlen(result));
+			if (ok && !settings->previewExt.empty()) {
+				ok = writeAsciiPreview(result, resultPath(*settings, job.name, settings->previewExt));
+			}
+		}
+		catch (const cv::Exception&) {
+			ok = false;
+		}
+		free(result);
+
+		{
+			std::lock_guard<std::mutex> guard(queue->lock);
+			queue->running.erase(job.name);
+			if (queue->again.erase(job.name)) pushJob(*queue, job.path, job.name);
+		}
+
+		Clock::time_point finished = Clock::now();
+		std::lock_guard<std::mutex> guard(logLock);
+		if (ok) {
+			std::cerr << job.name << " -> " << output << " in "
+				  << std::chrono::duration<double, std::milli>(finished - job.arrived).count() << " ms (waited "
+				  << std::chrono::duration<double, std::milli>(started - job.arrived).count() << " ms)" << std::endl;
+		}
+		else {
+			std::cerr << job.name << " could not be converted" << std::endl;
+		}
+	}
+}
+
+
+/* scanDirectory: queue every image in the spool without an up to date result. Used at start up, and
+ *	again whenever inotify reports that it lost events.
+*/
+static void scanDirectory(WatchQueue& queue, const WatchSettings& settings) {
+	std::error_code ec;
+	for (const fs::directory_entry& file : fs::directory_iterator(settings.watchDir, ec)) {
+		String name = file.path().filename().string();
+		if (!file.is_regular_file(ec) || !isWatchedFile(settings, name)) continue;
+		String output = resultPath(settings, name);
+		if (fs::exists(output, ec) && fs::last_write_time(output, ec) >= file.last_write_time(ec)) continue;
+		enqueue(queue, file.path().string(), name);
+	}
+}
+
+
+/**************************************
+ * Watch Interface ********************
+ **************************************/
+
+/* watchFolder: convert every image that arrives in a directory until the program is stopped. Images
+ *	already there without an up to date result are converted first. Returns -1 if the directory
+ *	cannot be watched.
+ * WatchSettings settings:	the directories, thread count and conversion settings
+*/
+int watchFolder(WatchSettings settings) {
+	std::error_code ec;
+	if (!settings.outputDir.empty()) fs::create_directories(settings.outputDir, ec);
+
+	int inotify = inotify_init1(IN_CLOEXEC);
+	if (inotify < 0 || inotify_add_watch(inotify, settings.watchDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		std::cout << "Could not watch the directory " << settings.watchDir << std::endl;
+		if (inotify >= 0) close(inotify);
+		return -1;
+	}
+
+	// start the pool before anything arrives, so no image waits on thread start up
+	WatchQueue queue;
+	int threads = settings.threads > 0 ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::thread> pool;
+	for (int i = 0; i < threads; i++) {
+		pool.emplace_back(convertJobs, &queue, &settings);
+	}
+
+	// pick up anything dropped in while we were not watching. The watch is already in place, so
+	// nothing can slip between the scan and the first event
+	scanDirectory(queue, settings);
+	std::cerr << "watching " << settings.watchDir << " with " << threads << " threads" << std::endl;
+
+	// room for a batch of events, each with the longest possible name
+	std::vector<char> events(64 * (sizeof(struct inotify_event) + NAME_MAX + 1));
+	for (;;) {
+		ssize_t len = read(inotify, events.data(), events.size());
+		if (len < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		for (char* at = events.data(); at < events.data() + len; ) {
+			struct inotify_event* event = (struct inotify_event*)at;
+			at += sizeof(struct inotify_event) + event->len;
+			if (event->mask & IN_Q_OVERFLOW) {
+				// the kernel's event queue filled up and some arrivals were lost, so look for them
+				{
+					std::lock_guard<std::mutex> guard(logLock);
+					std::cerr << "too many arrivals at once, rescanning " << settings.watchDir << std::endl;
+				}
+				scanDirectory(queue, settings);
+				continue;
+			}
+			if (event->len == 0 || (event->mask & IN_ISDIR)) continue;
+			String name = event->name;
+			if (isWatchedFile(settings, name)) enqueue(queue, settings.watchDir + "/" + name, name);
+		}
+	}
+
+	std::cout << "Stopped watching " << settings.watchDir << std::endl;
+	close(inotify);
+	// the pool threads never finish on their own, so leave them to exit with the process
+	for (std::thread& thread : pool) thread.detach();
+	return -1;
+}
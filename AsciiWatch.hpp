@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include "GenerateAscii.hpp"
+using namespace cv;
+
+/************************************************************************/
+/* ASCII Art Generator							*/
+/*									*/
+/* Copyright (C) 2025 Noah Board					*/
+/*									*/
+/* This program is free software: you can redistribute it and/or modify	*/
+/* it under the terms of the GNU General Public License as published by	*/
+/* the Free Software Foundation, either version 3 of the License, or	*/
+/* (at your option) any later version.					*/
+/*									*/
+/* This program is distributed in the hope that it will be useful, but	*/
+/* WITHOUT ANY WARRANTY; without even the implied warranty of		*/
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU	*/
+/* General Public License for more details.				*/
+/*									*/
+/* You should have received a copy of the GNU General Public License	*/
+/* along with this program. If not, see					*/
+/* <https://www.gnu.org/licenses/>.					*/
+/*									*/
+/* Author: Noah Board							*/
+/* Creation: 2025							*/
+/* Description: Watches a spool directory and converts each image	*/
+/*	as soon as it has been completely written			*/
+/************************************************************************/
+
+// constants
+const int MAX_WATCH_THREADS	= 256;
+
+// settings for watch mode
+struct WatchSettings {
+	String watchDir;		// the spool directory images are dropped into
+	String outputDir;		// where results go. Empty to put each one next to its image
+	int threads		= 0;	// conversion threads. 0 to use one per core
+	AsciiOptions opts;
+	String cacheDir;		// optional result cache
+	long cacheBytes		= 0;
+	String previewExt;		// image format for a preview of each result, e.g. ".png". Empty for none
+};
+
+// function declarations
+int watchFolder(WatchSettings settings);
@@ -7,7 +7,10 @@
 #include <filesystem>
 #include <queue>
 #include <cmath>
+#include <cstdio>
+#include <algorithm>
 #include "GenerateAscii.hpp"
+#include "AsciiInput.hpp"
 // #define DEBUG_MODE
 using namespace cv;
 
@@ -299,10 +302,10 @@ void angleReplace(int ascHeight, int ascWidth, char* result, float *source) {
 			// get the four values:	|a1|b1|
 			//			|a2|b2|
 			int square = 0;
-			int a1 =  source[(2 * x)	+ (2 * y)	* dblWidth];
-			int b1 =  source[(2 * x + 1)	+ (2 * y)	* dblWidth];
-			int a2 =  source[(2 * x)	+ (2 * y + 1)	* dblWidth];
-			int b2 =  source[(2 * x + 1)	+ (2 * y + 1)	* dblWidth];
+			float a1 =  source[(2 * x)	+ (2 * y)	* dblWidth];
+			float b1 =  source[(2 * x + 1)	+ (2 * y)	* dblWidth];
+			float a2 =  source[(2 * x)	+ (2 * y + 1)	* dblWidth];
+			float b2 =  source[(2 * x + 1)	+ (2 * y + 1)	* dblWidth];
 
 			double avgX = 0;
 			double avgY = 0;
@@ -395,14 +398,78 @@ void angleReplace(int ascHeight, int ascWidth, char* result, float *source) {
  **************************************/
 // these functions use an ascii identification function convert a preprocessed image into ascii art 
 
+/* asciiWidth: the width in characters (not counting the end of line) of ascii art made from src
+ * Mat src:		the image to be converted into ascii art
+ * int ascHeight:	the height of the ascii art in characters
+*/
+int asciiWidth(Mat src, int ascHeight) {
+	return asciiWidth(src.size(), ascHeight);
+}
+
+/* asciiWidth: the same, from just the size of the image
+ * Size src:		the size of the image to be converted into ascii art
+ * int ascHeight:	the height of the ascii art in characters
+*/
+int asciiWidth(Size src, int ascHeight) {
+	// TODO: look into how much this warps the image by rounding
+	return (int)(LEN_WID_RATIO * (double)(ascHeight) * (((double)src.width) / ((double)src.height)));
+}
+
+/* cellMeans: the mean of the pixels under each character of outline or angle ascii art. Those
+ *	characters are each made from 2x2 sub-cells of pixWidth by pixHeight pixels, rounded up so the
+ *	grid runs past the edge of the image, so the last rows and columns cover part of the image or
+ *	none of it. Each mean is over exactly the pixels of the image inside the character's cell.
+ *	Returns a Mat with src's channels, ascHeight rows by asciiWidth columns. Cells past the image are 0.
+ * Mat src:		the image to average (8 bit, any number of channels)
+ * int ascHeight:	the height of the ascii art in characters
+ * Size artSize:	the size of the image the art was made from. src may be a scaled copy of it
+ * Mat* covered:	if not NULL, set to a CV_8U Mat of the same size, non zero where a cell has pixels
+*/
+Mat cellMeans(Mat src, int ascHeight, Size artSize, Mat* covered) {
+	int ascWidth = std::max(asciiWidth(artSize, ascHeight), 1);
+	int pixHeight = (artSize.height / (ascHeight * 2)) + 1;
+	int pixWidth = (artSize.width / (ascWidth * 2)) + 1;
+	double scaleY = (double)src.rows / artSize.height;
+	double scaleX = (double)src.cols / artSize.width;
+	int channels = src.channels();
+
+	// a summed area table gives the sum of any rectangle from four lookups
+	Mat sums;
+	integral(src, sums, CV_64F);
+	Mat means(ascHeight, ascWidth, CV_8UC(channels), Scalar::all(0));
+	if (covered) *covered = Mat(ascHeight, ascWidth, CV_8U, Scalar(0));
+
+	for (int y = 0; y < ascHeight; y++) {
+		int yMin = std::min((int)(2 * y * pixHeight * scaleY), src.rows);
+		int yMax = std::min((int)(2 * (y + 1) * pixHeight * scaleY), src.rows);
+		if (yMax <= yMin) break;
+		const double* top = sums.ptr<double>(yMin);
+		const double* bottom = sums.ptr<double>(yMax);
+		uchar* mean = means.ptr<uchar>(y);
+		for (int x = 0; x < ascWidth; x++) {
+			int xMin = std::min((int)(2 * x * pixWidth * scaleX), src.cols);
+			int xMax = std::min((int)(2 * (x + 1) * pixWidth * scaleX), src.cols);
+			if (xMax <= xMin) break;
+			double area = (double)(yMax - yMin) * (xMax - xMin);
+			for (int c = 0; c < channels; c++) {
+				double sum = bottom[xMax * channels + c] - bottom[xMin * channels + c]
+					   - top[xMax * channels + c] + top[xMin * channels + c];
+				mean[x * channels + c] = saturate_cast<uchar>(sum / area);
+			}
+			if (covered) covered->at<uchar>(y, x) = 255;
+		}
+	}
+	return means;
+}
+
+
 /* outlineToAscii: Divides the image up into regions to be handled by an ascii identification function. Prints out the final result 
  * Mat src:		the image supplied by the user to be converted into ascii art
  * int ascHeight:	the height of the ascii art in characters
 */
 char * outlineToAscii(Mat src, int ascHeight) {
 	// Create the grid for the art. Start with heigh and calculate the width
-	// TODO: look into how much this warps the image by rounding
-	int ascWidth = (int)(LEN_WID_RATIO * (double)(ascHeight) * (((double)src.cols) / ((double)src.rows)));
+	int ascWidth = asciiWidth(src, ascHeight);
 	int giantAscWidth = ascWidth * 2;
 	int giantAscHeight = ascHeight * 2;
 
@@ -446,22 +513,21 @@ char * outlineToAscii(Mat src, int ascHeight) {
 	return ascArt;
 }
 
-/* sobelToAscii: Uses the Sobel filter to transform an image into the angles of the outlines. 
- *	These are then transformed into ascii art.
- * Mat src:		the image supplied by the user to be converted into ascii art
+/* angleToAscii: Divides an image of outline angles up into regions, and transforms the average angle
+ *	of each into ascii art.
+ * Mat angle:		the angle of the outline at each pixel in radians, or -1 where there is none (assumes float)
  * int ascHeight:	the height of the ascii art in characters
 */
-char * sobelToAscii(Mat src, int ascHeight) {
+char * angleToAscii(Mat angle, int ascHeight) {
 // Create the grid for the art. Start with heigh and calculate the width
-	// TODO: look into how much this warps the image by rounding
-	int ascWidth = (int)(LEN_WID_RATIO * (double)(ascHeight) * (((double)src.cols) / ((double)src.rows)));
+	int ascWidth = asciiWidth(angle, ascHeight);
 	int dblWidth = ascWidth * 2;
 	int dblHeight = ascHeight * 2;
 
 	// figure out how many pixels to each character
 	// Add to the pixel width to be sure all lines are seen, and then be careful not to read nonexistant pixels later
-	int pixHeight = (src.rows / dblHeight) + 1;
-	int pixWidth = (src.cols / dblWidth) + 1;
+	int pixHeight = (angle.rows / dblHeight) + 1;
+	int pixWidth = (angle.cols / dblWidth) + 1;
 
 	// Now make a grid of those dimensions
 	ascWidth++; // add an extra for the end lines
@@ -470,27 +536,27 @@ char * sobelToAscii(Mat src, int ascHeight) {
 	float* dblArt = (float*)malloc(sizeof(float) * dblHeight * dblWidth);
 	memset(ascArt, '\0', ((int)ascHeight) * (ascWidth));
 	memset(dblArt, '\0', (sizeof(float) * dblHeight * dblWidth));
-	
-	// need to run spatialGradient() to get x and y. Then for each pixel, run arctan. Then average angles for each region, then angle -> asciii
-	// later, want to do maybe quarter regions to help spot ^v<>, and maybe even ()UnO
 
-	Mat xSobel, ySobel, angle;
-	//src.convertTo(src, CV_32FC1);
-	Sobel(src, xSobel, 5, 1, 0, 1);
-	Sobel(src, ySobel, 5, 0, 1, 1);
-	//phase(xSobel, ySobel, angle, true);
-	angle = singleLinePhase(xSobel, ySobel, false);
+
 	// This should probably be a double line on snoopy - otherwise silhouettes would never showup right
-printf("\n\n--------------------------------------------------------------------------\n");
+	#ifdef DEBUG_MODE
+		printf("\n\n--------------------------------------------------------------------------\n");
+	#endif
 	for (int y = 0; y < dblHeight; y++) {
 		for (int x = 0; x < dblWidth - 1 ; x++) {
 			dblArt[x + y * dblWidth] = averageAngle(angle, x*pixWidth, (x + 1) * pixWidth, y*pixHeight, (y+1)*pixHeight);
-			printf("%f, ", dblArt[x + y * dblWidth]);
+			#ifdef DEBUG_MODE
+				printf("%f, ", dblArt[x + y * dblWidth]);
+			#endif
 		}
 		dblArt[(y + 1) * dblWidth - 1] = '\n';
-		printf("\n");
+		#ifdef DEBUG_MODE
+			printf("\n");
+		#endif
 	}
-	printf("\n\n--------------------------------------------------------------------------\n");
+	#ifdef DEBUG_MODE
+		printf("\n\n--------------------------------------------------------------------------\n");
+	#endif
 //	printf("##########################################################################\n");
 //	printf("--------------------------------------------------------------------------\n\n\n");
 	//std::cout << angle << std::endl;
@@ -501,12 +567,328 @@ printf("\n\n--------------------------------------------------------------------
 
 	angleReplace(ascHeight, ascWidth, ascArt, dblArt);
 
-	std::cout << dblArt << std::endl;
+	free(dblArt);
 
+	return ascArt;
+}
+
+/* sobelToAscii: Uses the Sobel filter to transform an image into the angles of the outlines. 
+ *	These are then transformed into ascii art.
+ * Mat src:		the image supplied by the user to be converted into ascii art
+ * int ascHeight:	the height of the ascii art in characters
+*/
+char * sobelToAscii(Mat src, int ascHeight) {
+	// need to run spatialGradient() to get x and y. Then for each pixel, run arctan. Then average angles for each region, then angle -> asciii
+	// later, want to do maybe quarter regions to help spot ^v<>, and maybe even ()UnO
+
+	Mat xSobel, ySobel, angle;
+	//src.convertTo(src, CV_32FC1);
+	Sobel(src, xSobel, 5, 1, 0, 1);
+	Sobel(src, ySobel, 5, 0, 1, 1);
+	//phase(xSobel, ySobel, angle, true);
+	angle = singleLinePhase(xSobel, ySobel, false);
+	return angleToAscii(angle, ascHeight);
+}
+
+/* shadeTable: a 256 entry lookup table from brightness to a character of the ramp */
+static Mat shadeTable(String ramp) {
+	if (ramp.empty()) ramp = DEFAULT_SHADE_RAMP;
+	Mat table(1, 256, CV_8U);
+	for (int i = 0; i < 256; i++) {
+		table.at<uchar>(0, i) = ramp[(i * ramp.size()) / 256];
+	}
+	return table;
+}
+
+/* shadeGlyphs: pick a character for every cell from the mean brightness of the pixels under it.
+ *	The image is area-resampled once down to one pixel per character, then a 256 entry lookup
+ *	table maps each brightness straight to a character of the ramp.
+ *	Returns a CV_8U Mat of characters, one per cell, ascHeight rows by asciiWidth columns.
+ * Mat srcGray:		the grayscale image supplied by the user
+ * int ascHeight:	the height of the ascii art in characters
+ * String ramp:		characters ordered from darkest to lightest
+*/
+Mat shadeGlyphs(Mat srcGray, int ascHeight, String ramp) {
+	int ascWidth = std::max(asciiWidth(srcGray, ascHeight), 1);
+	Mat cells, glyphs;
+	resize(srcGray, cells, Size(ascWidth, ascHeight), 0, 0, INTER_AREA);
+	LUT(cells, shadeTable(ramp), glyphs);
+	return glyphs;
+}
 
+/* fillGlyphs: shading to go under outline or angle ascii art with shadeFill. Unlike shadeGlyphs, the
+ *	cells line up with the ones the outlines were made from (see cellMeans), and cells that run
+ *	past the edge of the image are left blank.
+ * Mat srcGray:		the grayscale image the outlines were made from
+ * int ascHeight:	the height of the ascii art in characters
+ * String ramp:		characters ordered from darkest to lightest
+*/
+Mat fillGlyphs(Mat srcGray, int ascHeight, String ramp) {
+	Mat covered, glyphs;
+	Mat cells = cellMeans(srcGray, ascHeight, srcGray.size(), &covered);
+	LUT(cells, shadeTable(ramp), glyphs);
+	for (int y = 0; y < glyphs.rows; y++) {
+		for (int x = 0; x < glyphs.cols; x++) {
+			if (!covered.at<uchar>(y, x)) glyphs.at<uchar>(y, x) = ' ';
+		}
+	}
+	return glyphs;
+}
+
+/* shadeToAscii: converts an image into ascii art by brightness alone. No edge detection is used,
+ *	so it works on soft photos where the outline methods find nothing, and is much cheaper.
+ * Mat srcGray:		the grayscale image supplied by the user
+ * int ascHeight:	the height of the ascii art in characters
+ * String ramp:		characters ordered from darkest to lightest
+*/
+char * shadeToAscii(Mat srcGray, int ascHeight, String ramp) {
+	Mat glyphs = shadeGlyphs(srcGray, ascHeight, ramp);
+	int ascWidth = glyphs.cols + 1; // add an extra for the end lines
+	char* ascArt = (char*)malloc(sizeof(char) * ascHeight * ascWidth);
+	for (int y = 0; y < ascHeight; y++) {
+		memcpy(ascArt + y * ascWidth, glyphs.ptr<uchar>(y), glyphs.cols);
+		ascArt[(y + 1) * ascWidth - 1] = '\n';
+	}
+	ascArt[ascHeight * ascWidth - 1] = '\0';
 	return ascArt;
 }
 
+/* shadeFill: fill the blank cells of edge based ascii art with the shading from fillGlyphs,
+ *	so the outlines sit on top of a brightness layer
+ * char* ascArt:	the ascii art from outlineToAscii or sobelToAscii
+ * Mat glyphs:		the shading characters from fillGlyphs, for the same image and height
+*/
+void shadeFill(char* ascArt, Mat glyphs) {
+	int ascWidth = glyphs.cols + 1;
+	for (int y = 0; y < glyphs.rows; y++) {
+		const uchar* shade = glyphs.ptr<uchar>(y);
+		char* row = ascArt + y * ascWidth;
+		for (int x = 0; x < glyphs.cols; x++) {
+			if (row[x] == ' ') row[x] = shade[x];
+		}
+	}
+}
+
+/* ansiColorCode: quantise a color for an escape sequence. Returns a code that is equal for two colors
+ *	exactly when their escape sequences would be, so runs of the same color can be detected.
+ *	In 256 color mode this is the xterm palette index. In truecolor mode each channel keeps its top 5
+ *	bits, which is not visible in text but lets neighbouring cells share far more escapes.
+ * uchar b, g, r:	the color
+ * int colorMode:	1 for 256 colors, 2 for truecolor
+*/
+static int ansiColorCode(uchar b, uchar g, uchar r, int colorMode) {
+	if (colorMode == 2) {
+		return ((r & 0xF8) << 16) | ((g & 0xF8) << 8) | (b & 0xF8);
+	}
+
+	// nearest entry of the 6x6x6 cube, whose levels are 0, 95, 135, 175, 215, 255
+	const int LEVELS[6] = { 0, 95, 135, 175, 215, 255 };
+	int ri = (r < 48) ? 0 : (r < 115) ? 1 : (r - 35) / 40;
+	int gi = (g < 48) ? 0 : (g < 115) ? 1 : (g - 35) / 40;
+	int bi = (b < 48) ? 0 : (b < 115) ? 1 : (b - 35) / 40;
+	int cubeDist = (r - LEVELS[ri]) * (r - LEVELS[ri]) + (g - LEVELS[gi]) * (g - LEVELS[gi]) + (b - LEVELS[bi]) * (b - LEVELS[bi]);
+
+	// and of the gray ramp, whose levels are 8, 18, ... 238
+	int gray = (r + g + b) / 3;
+	int grayi = std::min(std::max((gray - 3) / 10, 0), 23);
+	int level = 8 + 10 * grayi;
+	int grayDist = (r - level) * (r - level) + (g - level) * (g - level) + (b - level) * (b - level);
+
+	return (grayDist < cubeDist) ? 232 + grayi : 16 + 36 * ri + 6 * gi + bi;
+}
+
+/* colorizeAscii: add ANSI color to ascii art. Each character takes the mean color of the pixels it
+ *	was made from: the same cells as the outlines (see cellMeans), or for shading one area resample
+ *	of the color image. An escape sequence is only written when the color changes, and spaces never
+ *	need one, so output stays close to the size of the plain art.
+ *	Returns a new character array; the original is left alone.
+ * const char* ascArt:	the ascii art to color
+ * Mat src:		the original color (BGR) or grayscale image
+ * int colorMode:	1 for 256 colors, 2 for truecolor
+ * Size artSize:	for outline or angle art, the size of the image it was made from (src may be
+ *			a scaled copy of it). An empty Size for shading, whose cells spread evenly over the image
+*/
+char * colorizeAscii(const char* ascArt, Mat src, int colorMode, Size artSize) {
+	// size of the grid: the first row is as wide as any
+	int ascWidth = strcspn(ascArt, "\n");
+	int ascHeight = 1;
+	for (const char* c = ascArt; *c; c++) {
+		if (*c == '\n' && c[1] != '\0') ascHeight++;
+	}
+
+	Mat cells;
+	if (ascWidth > 0 && artSize.area() > 0) cells = cellMeans(src, ascHeight, artSize);
+	else if (ascWidth > 0) resize(src, cells, Size(ascWidth, ascHeight), 0, 0, INTER_AREA);
+	bool isGray = (src.channels() == 1);
+
+	std::string colored;
+	colored.reserve(strlen(ascArt) * 2);
+	char escape[32];
+	int x = 0, y = 0;
+	int lastCode = -1; // nothing set yet on this row
+	for (const char* c = ascArt; *c; c++) {
+		if (*c == '\n') {
+			// reset at the end of each row so nothing bleeds into whatever comes after
+			if (lastCode != -1) colored += "\x1b[0m";
+			colored += '\n';
+			lastCode = -1;
+			x = 0;
+			y++;
+			continue;
+		}
+		if (*c != ' ' && x < cells.cols && y < cells.rows) {
+			uchar b, g, r;
+			if (isGray) {
+				b = g = r = cells.at<uchar>(y, x);
+			}
+			else {
+				Vec3b color = cells.at<Vec3b>(y, x);
+				b = color[0];
+				g = color[1];
+				r = color[2];
+			}
+			int code = ansiColorCode(b, g, r, colorMode);
+			if (code != lastCode) {
+				if (colorMode == 2) snprintf(escape, sizeof(escape), "\x1b[38;2;%d;%d;%dm", (code >> 16) & 0xFF, (code >> 8) & 0xFF, code & 0xFF);
+				else snprintf(escape, sizeof(escape), "\x1b[38;5;%dm", code);
+				colored += escape;
+				lastCode = code;
+			}
+		}
+		colored += *c;
+		x++;
+	}
+	if (lastCode != -1) colored += "\x1b[0m";
+
+	char* result = (char*)malloc(colored.size() + 1);
+	memcpy(result, colored.c_str(), colored.size() + 1);
+	return result;
+}
+
+/* streamOutlineToAscii: Same as outlineToAscii, but writes each row of characters to out as soon as 
+ *	it is finished instead of returning the whole image. Only one row is held in memory at a time.
+ * Mat src:		the image supplied by the user to be converted into ascii art
+ * int ascHeight:	the height of the ascii art in characters
+ * FILE* out:		where to write the rows
+ * Mat fill:		shading from fillGlyphs to put in the blank cells, or an empty Mat for none
+*/
+void streamOutlineToAscii(Mat src, int ascHeight, FILE* out, Mat fill) {
+	int ascWidth = asciiWidth(src, ascHeight);
+	int giantAscWidth = ascWidth * 2;
+	int giantAscHeight = ascHeight * 2;
+	int pixHeight = (src.rows / giantAscHeight) + 1;
+	int pixWidth = (src.cols / giantAscWidth) + 1;
+
+	// room for the two sub-cell rows of the 2x image, and the one row of characters made from them
+	ascWidth++;
+	giantAscWidth++;
+	char* giantRows = (char*)malloc(sizeof(char) * 2 * giantAscWidth);
+	char* ascRow = (char*)malloc(sizeof(char) * ascWidth);
+
+	for (int row = 0; row < ascHeight; row++) {
+		for (int sub = 0; sub < 2; sub++) {
+			int y = 2 * row + sub;
+			for (int x = 0; x < giantAscWidth - 1; x++) {
+				if (isWhite(src, x*pixWidth, (x + 1) * pixWidth, y*pixHeight, (y+1)*pixHeight)) {
+					giantRows[x + sub * giantAscWidth] = '#';
+				}
+				else {
+					giantRows[x + sub * giantAscWidth] = ' ';
+				}
+			}
+			giantRows[(sub + 1) * giantAscWidth - 1] = '\n';
+		}
+
+		// condense the pair into one row. simpleReplace ends its last row with '\0', so put the '\n' back
+		simpleReplace(1, ascWidth, ascRow, giantRows);
+		ascRow[ascWidth - 1] = '\n';
+		if (!fill.empty()) shadeFill(ascRow, fill.row(row));
+		fwrite(ascRow, sizeof(char), ascWidth, out);
+		if (row == 0) fflush(out); // don't let the buffer hold back the first line
+	}
+	fflush(out);
+
+	free(giantRows);
+	free(ascRow);
+}
+
+/* streamAngleRows: the row loop shared by streamSobelToAscii and streamAngleToAscii.
+ * Mat src:		the image to convert, either preprocessed pixels or outline angles
+ * bool isAngle:	true if src already holds angles; otherwise they are found a band at a time
+ * int ascHeight:	the height of the ascii art in characters
+ * FILE* out:		where to write the rows
+ * Mat fill:		shading from fillGlyphs to put in the blank cells, or an empty Mat for none
+*/
+static void streamAngleRows(Mat src, bool isAngle, int ascHeight, FILE* out, Mat fill) {
+	int ascWidth = asciiWidth(src, ascHeight);
+	int dblWidth = ascWidth * 2;
+	int dblHeight = ascHeight * 2;
+	int pixHeight = (src.rows / dblHeight) + 1;
+	int pixWidth = (src.cols / dblWidth) + 1;
+
+	ascWidth++;
+	dblWidth++;
+	float* dblRows = (float*)malloc(sizeof(float) * 2 * dblWidth);
+	char* ascRow = (char*)malloc(sizeof(char) * ascWidth);
+
+	for (int row = 0; row < ascHeight; row++) {
+		// Sobel on a band of rows still reads the real neighbouring pixels above and below it
+		int bandStart = std::min(2 * row * pixHeight, src.rows);
+		int bandEnd = std::min((2 * row + 2) * pixHeight, src.rows);
+		Mat angle;
+		if (bandEnd > bandStart && isAngle) {
+			angle = src.rowRange(bandStart, bandEnd);
+		}
+		else if (bandEnd > bandStart) {
+			Mat xSobel, ySobel;
+			Mat band = src.rowRange(bandStart, bandEnd);
+			Sobel(band, xSobel, 5, 1, 0, 1);
+			Sobel(band, ySobel, 5, 0, 1, 1);
+			angle = singleLinePhase(xSobel, ySobel, false);
+		}
+
+		for (int sub = 0; sub < 2; sub++) {
+			for (int x = 0; x < dblWidth - 1; x++) {
+				if (angle.empty()) dblRows[x + sub * dblWidth] = -1;
+				else dblRows[x + sub * dblWidth] = averageAngle(angle, x*pixWidth, (x + 1) * pixWidth, sub*pixHeight, (sub+1)*pixHeight);
+			}
+			dblRows[(sub + 1) * dblWidth - 1] = -1;
+		}
+
+		angleReplace(1, ascWidth, ascRow, dblRows);
+		ascRow[ascWidth - 1] = '\n';
+		if (!fill.empty()) shadeFill(ascRow, fill.row(row));
+		fwrite(ascRow, sizeof(char), ascWidth, out);
+		if (row == 0) fflush(out);
+	}
+	fflush(out);
+
+	free(dblRows);
+	free(ascRow);
+}
+
+/* streamSobelToAscii: Same as sobelToAscii, but writes each row of characters to out as soon as 
+ *	it is finished. The angles are only calculated for the band of pixels behind the current row.
+ * Mat src:		the image supplied by the user to be converted into ascii art
+ * int ascHeight:	the height of the ascii art in characters
+ * FILE* out:		where to write the rows
+ * Mat fill:		shading from fillGlyphs to put in the blank cells, or an empty Mat for none
+*/
+void streamSobelToAscii(Mat src, int ascHeight, FILE* out, Mat fill) {
+	streamAngleRows(src, false, ascHeight, out, fill);
+}
+
+/* streamAngleToAscii: Same as angleToAscii, but writes each row of characters to out as soon as 
+ *	it is finished.
+ * Mat angle:		the outline angles, as for angleToAscii
+ * int ascHeight:	the height of the ascii art in characters
+ * FILE* out:		where to write the rows
+ * Mat fill:		shading from fillGlyphs to put in the blank cells, or an empty Mat for none
+*/
+void streamAngleToAscii(Mat angle, int ascHeight, FILE* out, Mat fill) {
+	streamAngleRows(angle, true, ascHeight, out, fill);
+}
+
 // TODO: make a line follow algorithm that just tries to link up adjacent "lit" areas
 
 /**************************************
@@ -613,7 +995,7 @@ void demoCannyImage(String fileName, int blurThreshold, int lowThreshold, int ra
 	createTrackbar("Min Threshold:", WINDOW_NAME_C, &demoLowThreshold, MAX_LOW_THRESHOLD, CannyThreshold);
 	createTrackbar("Blur Threshold:", WINDOW_NAME_C, &demoBlurThreshold, MAX_BLUR_THRESHOLD, CannyThreshold);
 	createTrackbar("ratio:", WINDOW_NAME_C, &demoRatio, MAX_RATIO, CannyThreshold);
-	createTrackbar("size:", WINDOW_NAME_C, &demoAsciiHeight, MAX_ASCII_HEIGHT, CannyThreshold);
+	createTrackbar("size:", WINDOW_NAME_C, &demoAsciiHeight, MAX_DEMO_ASCII_HEIGHT, CannyThreshold);
 	CannyThreshold(0, 0);
 
 	waitKey(0);
@@ -655,66 +1037,111 @@ void demoGaussImage(String fileName, int kernalSize1, int kernalSize2, int media
 	createTrackbar("Gauss 1:", WINDOW_NAME_G, &demoKernalSize1, MAX_KERNAL_SIZE_1, diffOfGaussians);
 	createTrackbar("Gauss 2:", WINDOW_NAME_G, &demoKernalSize2, MAX_KERNAL_SIZE_2, diffOfGaussians);
 	createTrackbar("Brightness Threshold:", WINDOW_NAME_G, &demoPixelThreshold, MAX_PIXEL_THRESHOLD, diffOfGaussians);
-	createTrackbar("size:", WINDOW_NAME_G, &demoAsciiHeight, MAX_ASCII_HEIGHT, diffOfGaussians);
+	createTrackbar("size:", WINDOW_NAME_G, &demoAsciiHeight, MAX_DEMO_ASCII_HEIGHT, diffOfGaussians);
 	diffOfGaussians(0, 0);
 
 	waitKey(0);
 }
 
 
-/* convertCannyImage: convert an image to ascii and return the result as a character array
- * Uses canny edge detection and converts lines to ascii characters based on the presence 
- * or absence of pixels.
+/* loadColorImage: load an image supplied by the user in BGR color.
+ * Returns an empty Mat if the image could not be found or read.
  * String fileName:	path to the image supplied by the user
- * int blurThreshold:	parameter for image preprocessing
- * int lowThreshold:	parameter for image preprocessing
- * int ratio:		parameter for image preprocessing
- * int kernelSize:	parameter for image preprocessing
- * int ascHeight:	the target size for the final image in characters 
 */
-char* convertCannyImage(String fileName, int blurThreshold, int lowThreshold, int ratio, int kernelSize, int ascHeight){
-	Mat src, srcGray, detectedEdges;
-	src = imread(samples::findFile(fileName), IMREAD_COLOR); // Load an image
+Mat loadColorImage(String fileName){
+	// not required, so a missing file gives an empty Mat rather than an exception
+	String path = samples::findFile(fileName, false, true);
+	Mat src;
+	if (!path.empty()) src = imread(path, IMREAD_COLOR); // Load an image
 	if (src.empty())
 	{
 		std::cout << "Could not open or find the image " << fileName << std::endl;
-		return NULL;
 	}
+	return src;
+}
 
-	//set up for processing
+/* loadGrayImage: load an image supplied by the user and convert it to grayscale for processing.
+ * Returns an empty Mat if the image could not be read.
+ * String fileName:	path to the image supplied by the user
+*/
+Mat loadGrayImage(String fileName){
+	Mat src, srcGray;
+	src = loadColorImage(fileName);
+	if (src.empty()) return src;
 	cvtColor(src, srcGray, COLOR_BGR2GRAY);
+	return srcGray;
+}
 
-	// process image
+/* cannyEdges: preprocess a grayscale image with a blur and canny edge detection
+ * Mat srcGray:		the grayscale image to process
+ * int blurThreshold:	parameter for image preprocessing
+ * int lowThreshold:	parameter for image preprocessing
+ * int ratio:		parameter for image preprocessing
+ * int kernelSize:	parameter for image preprocessing
+*/
+Mat cannyEdges(Mat srcGray, int blurThreshold, int lowThreshold, int ratio, int kernelSize){
+	Mat detectedEdges;
 	if (blurThreshold == 0) blurThreshold = 1;
 	blur(srcGray, detectedEdges, Size(blurThreshold, blurThreshold));
 	Canny(detectedEdges, detectedEdges, lowThreshold, lowThreshold * ratio, kernelSize);
-	return outlineToAscii(detectedEdges, ascHeight);
+	return detectedEdges;
 }
 
-/* convertGaussImage: convert an image to ascii and return the result as a character array
- * Uses a difference of gaussians and sobel, and uses the resulting angels to create ascii
- * String fileName:	path to the image supplied by the user
- * int kernalSize1:	initial Kernal size for the first gaussian blur
- * int kernalSize2:	initial Kernal size for the second gaussian blur
- * int medianBlurSize:	parameter for image preprocessing
- * int pixelThreshold:	brightness threshold for post processed pixels to be considered
- * int ascHeight:	the target size for the final image in characters 
-**/
-char* convertGaussImage(String fileName, int kernalSize1, int kernalSize2, int medianBlurSize, int pixelThreshold, int ascHeight){
-	Mat src, srcGray, detectedEdges, gaus1, gaus2, medBlur;
-	
-	src = imread(samples::findFile(fileName), IMREAD_COLOR); // Load an image
-	if (src.empty())
-	{
-		std::cout << "Could not open or find the image!\n" << std::endl;
-		return NULL;
+/* cannyAngles: canny edge detection that also gives the direction of each edge. The gradients are
+ *	calculated once, the same way Canny would internally, then handed to Canny and reused for the
+ *	angles. Returns a float image of angles in radians (as singleLinePhase gives) on the edges, and -1
+ *	everywhere else, ready for angleToAscii.
+ * Mat srcGray:		the grayscale image to process
+ * int blurThreshold:	parameter for image preprocessing
+ * int lowThreshold:	parameter for image preprocessing
+ * int ratio:		parameter for image preprocessing
+ * int kernelSize:	parameter for image preprocessing
+*/
+Mat cannyAngles(Mat srcGray, int blurThreshold, int lowThreshold, int ratio, int kernelSize){
+	Mat blurred, dx, dy, detectedEdges;
+	if (blurThreshold == 0) blurThreshold = 1;
+	blur(srcGray, blurred, Size(blurThreshold, blurThreshold));
+	// for the 7 wide aperture Canny scales the gradients down by 16 (which also keeps them inside a
+	// short) and its thresholds with them. This overload does neither, so match both here
+	double scale = (kernelSize == 7) ? 1 / 16.0 : 1;
+	Sobel(blurred, dx, CV_16S, 1, 0, kernelSize, scale, 0, BORDER_REPLICATE);
+	Sobel(blurred, dy, CV_16S, 0, 1, kernelSize, scale, 0, BORDER_REPLICATE);
+
+	double low = lowThreshold;
+	double high = lowThreshold * ratio;
+	if (kernelSize == 7) {
+		low /= 16.0;
+		high /= 16.0;
+	}
+	Canny(dx, dy, detectedEdges, low, high);
+
+	Mat angle(srcGray.rows, srcGray.cols, CV_32F);
+	for (int y = 0; y < angle.rows; y++) {
+		const uchar* edge = detectedEdges.ptr<uchar>(y);
+		const short* gx = dx.ptr<short>(y);
+		const short* gy = dy.ptr<short>(y);
+		float* out = angle.ptr<float>(y);
+		for (int x = 0; x < angle.cols; x++) {
+			if (edge[x] == 0) out[x] = -1;
+			else {
+				float theta = atan2((float)gy[x], (float)gx[x]);
+				out[x] = (theta < 0) ? theta + 2 * M_PI : theta;
+			}
+		}
 	}
+	return angle;
+}
 
-	//set up for processing
-	cvtColor(src, srcGray, COLOR_BGR2GRAY);
-	
-	// copy image so can make changes without affecting original
-	detectedEdges = srcGray.clone();
+/* gaussEdges: preprocess a grayscale image with a difference of gaussians, leaving only
+ * the pixels brighter than the threshold lit
+ * Mat srcGray:		the grayscale image to process
+ * int kernalSize1:	Kernal size for the first gaussian blur
+ * int kernalSize2:	Kernal size for the second gaussian blur
+ * int medianBlurSize:	parameter for image preprocessing
+ * int pixelThreshold:	brightness threshold for post processed pixels to be considered
+*/
+Mat gaussEdges(Mat srcGray, int kernalSize1, int kernalSize2, int medianBlurSize, int pixelThreshold){
+	Mat detectedEdges, gaus1, gaus2, medBlur;
 
 	// correct input values
 	if(!(kernalSize1&1)) kernalSize1+=1;
@@ -722,8 +1149,8 @@ char* convertGaussImage(String fileName, int kernalSize1, int kernalSize2, int m
 	if(!(medianBlurSize&1)) medianBlurSize+=1;
 	if(!(pixelThreshold&1)) pixelThreshold+=1;
 
-	// blur first to help
-	medianBlur(detectedEdges, medBlur, medianBlurSize);
+	// blur first to help. This writes a new image, so the original is not affected
+	medianBlur(srcGray, medBlur, medianBlurSize);
 
 	// perform edge detection
 	GaussianBlur(medBlur, gaus1, Size(kernalSize1,kernalSize1), 0);
@@ -738,7 +1165,172 @@ char* convertGaussImage(String fileName, int kernalSize1, int kernalSize2, int m
 	inRange(detectedEdges, Scalar(0, 0, 0), 
 		Scalar(pixelThreshold, pixelThreshold, pixelThreshold), mask);
 	detectedEdges.setTo(Scalar(0, 0, 0), mask);
+	return detectedEdges;
+}
+
+/* preprocessImage: run the preprocess method selected in opts on a grayscale image.
+ * Shading works on the grayscale image directly, so it is returned unchanged. Canny with angles
+ * returns the angles from cannyAngles.
+ * Mat srcGray:		the grayscale image to process
+ * AsciiOptions opts:	the preprocess method and its parameters
+*/
+Mat preprocessImage(Mat srcGray, AsciiOptions opts){
+	if (opts.preProcess == 1 && opts.angles)
+		return cannyAngles(srcGray, opts.blurThreshold, opts.lowThreshold, opts.ratio, opts.kernelSize);
+	if (opts.preProcess == 1)
+		return cannyEdges(srcGray, opts.blurThreshold, opts.lowThreshold, opts.ratio, opts.kernelSize);
+	if (opts.preProcess == 2)
+		return srcGray;
+	return gaussEdges(srcGray, opts.kernal1, opts.kernal2, opts.median, opts.threshold);
+}
+
+/* edgesToAscii: convert the output of preprocessImage into ascii art with the method that matches it,
+ * and return the result as a character array
+ * Mat detectedEdges:	the image returned by preprocessImage
+ * AsciiOptions opts:	the preprocess method and its parameters
+*/
+char* edgesToAscii(Mat detectedEdges, AsciiOptions opts){
+	switch (opts.preProcess){
+		case 0:
+			return sobelToAscii(detectedEdges, opts.ascHeight);
+		case 1:
+			if (opts.angles) return angleToAscii(detectedEdges, opts.ascHeight);
+			return outlineToAscii(detectedEdges, opts.ascHeight);
+		case 2:
+			return shadeToAscii(detectedEdges, opts.ascHeight, opts.ramp);
+		default:
+			return NULL;
+	}
+}
+
+
+/* convertCannyImage: convert an image to ascii and return the result as a character array
+ * Uses canny edge detection and converts lines to ascii characters based on the presence 
+ * or absence of pixels.
+ * String fileName:	path to the image supplied by the user
+ * int blurThreshold:	parameter for image preprocessing
+ * int lowThreshold:	parameter for image preprocessing
+ * int ratio:		parameter for image preprocessing
+ * int kernelSize:	parameter for image preprocessing
+ * int ascHeight:	the target size for the final image in characters 
+*/
+char* convertCannyImage(String fileName, int blurThreshold, int lowThreshold, int ratio, int kernelSize, int ascHeight){
+	Mat srcGray = loadGrayImage(fileName);
+	if (srcGray.empty()) return NULL;
+
+	// process image
+	return outlineToAscii(cannyEdges(srcGray, blurThreshold, lowThreshold, ratio, kernelSize), ascHeight);
+}
+
+/* convertGaussImage: convert an image to ascii and return the result as a character array
+ * Uses a difference of gaussians and sobel, and uses the resulting angels to create ascii
+ * String fileName:	path to the image supplied by the user
+ * int kernalSize1:	initial Kernal size for the first gaussian blur
+ * int kernalSize2:	initial Kernal size for the second gaussian blur
+ * int medianBlurSize:	parameter for image preprocessing
+ * int pixelThreshold:	brightness threshold for post processed pixels to be considered
+ * int ascHeight:	the target size for the final image in characters 
+**/
+char* convertGaussImage(String fileName, int kernalSize1, int kernalSize2, int medianBlurSize, int pixelThreshold, int ascHeight){
+	Mat srcGray = loadGrayImage(fileName);
+	if (srcGray.empty()) return NULL;
 
 	// print the result
-	return sobelToAscii(detectedEdges, ascHeight);
+	return sobelToAscii(gaussEdges(srcGray, kernalSize1, kernalSize2, medianBlurSize, pixelThreshold), ascHeight);
+}
+
+
+/* convertShadeImage: convert an image to ascii by brightness and return the result as a character array
+ * String fileName:	path to the image supplied by the user
+ * String ramp:		characters ordered from darkest to lightest
+ * int ascHeight:	the target size for the final image in characters 
+**/
+char* convertShadeImage(String fileName, String ramp, int ascHeight){
+	Mat srcGray = loadGrayImage(fileName);
+	if (srcGray.empty()) return NULL;
+	return shadeToAscii(srcGray, ascHeight, ramp);
+}
+
+/* convertGrayImage: convert an already loaded grayscale image to ascii using the preprocess method 
+ * and parameters in opts, and return the result as a character array
+ * Mat srcGray:		the grayscale image to convert
+ * AsciiOptions opts:	the preprocess method and its parameters
+**/
+char* convertGrayImage(Mat srcGray, AsciiOptions opts){
+	char* result = edgesToAscii(preprocessImage(srcGray, opts), opts);
+	if (result && opts.fill && opts.preProcess != 2) shadeFill(result, fillGlyphs(srcGray, opts.ascHeight, opts.ramp));
+	return result;
+}
+
+/* convertImage: convert an image to ascii using the preprocess method and parameters in opts.
+ * Returns the result as a character array, or NULL if the image could not be read.
+ * String fileName:	path to the image supplied by the user
+ * AsciiOptions opts:	the preprocess method and its parameters
+**/
+char* convertImage(String fileName, AsciiOptions opts){
+	// uncompressed PGM/PPM files are mapped and used in place rather than decoded.
+	// The color image is only kept when it is needed for colorizing
+	MappedImage mapped;
+	Mat src, srcGray;
+	if (mapNetpbm(fileName, mapped)) {
+		srcGray = mappedGray(mapped);
+		if (opts.color && mapped.image.channels() == 3) cvtColor(mapped.image, src, COLOR_RGB2BGR);
+		else if (opts.color) src = mapped.image;
+	}
+	else if (opts.color) {
+		src = loadColorImage(fileName);
+		if (!src.empty()) cvtColor(src, srcGray, COLOR_BGR2GRAY);
+	}
+	else {
+		srcGray = loadGrayImage(fileName);
+	}
+
+	char* result = srcGray.empty() ? NULL : convertGrayImage(srcGray, opts);
+	if (result && opts.color) {
+		char* colored = colorizeAscii(result, src, opts.color, opts.preProcess == 2 ? Size() : srcGray.size());
+		free(result);
+		result = colored;
+	}
+	if (!unmapImage(mapped)) {
+		std::cout << fileName << " was cut short while it was being read" << std::endl;
+		free(result);
+		result = NULL;
+	}
+	return result;
+}
+
+/* streamImage: convert an image to ascii, writing each row to out as soon as it is finished.
+ * Intended for very tall output, where building the whole result first would delay the first
+ * line and hold the entire image in memory. Returns false if the image could not be read.
+ * String fileName:	path to the image supplied by the user
+ * AsciiOptions opts:	the preprocess method and its parameters
+ * FILE* out:		where to write the rows. Give it a large buffer with setvbuf first
+**/
+bool streamImage(String fileName, AsciiOptions opts, FILE* out){
+	MappedImage mapped;
+	Mat srcGray = mapNetpbm(fileName, mapped) ? mappedGray(mapped) : loadGrayImage(fileName);
+	if (srcGray.empty()) return false;
+
+	// shading is a single cheap pass, so it is simply written out whole
+	if (opts.preProcess == 2) {
+		char* result = shadeToAscii(srcGray, opts.ascHeight, opts.ramp);
+		fputs(result, out);
+		fputc('\n', out);
+		fflush(out);
+		free(result);
+	}
+	else {
+		Mat fill;
+		if (opts.fill) fill = fillGlyphs(srcGray, opts.ascHeight, opts.ramp);
+		Mat detectedEdges = preprocessImage(srcGray, opts);
+		if (opts.preProcess == 1 && opts.angles) streamAngleToAscii(detectedEdges, opts.ascHeight, out, fill);
+		else if (opts.preProcess == 1) streamOutlineToAscii(detectedEdges, opts.ascHeight, out, fill);
+		else streamSobelToAscii(detectedEdges, opts.ascHeight, out, fill);
+	}
+	// the rows are already out, so all that can be done is to say they are wrong
+	if (!unmapImage(mapped)) {
+		std::cerr << fileName << " was cut short while it was being read" << std::endl;
+		return false;
+	}
+	return true;
 }
\ No newline at end of file
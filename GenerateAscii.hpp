@@ -34,18 +34,62 @@ const std::string WINDOW_NAME_G = "Gauss Demo Mode";
 const int MAX_BLUR_THRESHOLD 	= 50;
 const int MAX_LOW_THRESHOLD	= 100;
 const int MAX_RATIO 		= 100;
-const int MAX_ASCII_HEIGHT	= 100;
+const int MAX_ASCII_HEIGHT	= 20000; // poster sized output. Use streamImage for anything this tall
+const int MAX_DEMO_ASCII_HEIGHT	= 100;
+const int STREAM_BUFFER_SIZE	= 1 << 20;
+const std::string DEFAULT_SHADE_RAMP = "@%#*+=-:. "; // darkest to lightest
 const int MAX_KERNAL_SIZE_1	= 100;
 const int MAX_KERNAL_SIZE_2	= 100;
 const int MAX_MEDIAN_BLUR_SIZE	= 100;
 const int MAX_PIXEL_THRESHOLD	= 255;
 
+// settings for a single conversion. Defaults match the command line defaults
+struct AsciiOptions {
+	int preProcess		= 0; // 0 = Gauss, 1 = Canny, 2 = Shade
+	int blurThreshold	= 3;
+	int lowThreshold	= 21;
+	int ratio		= 4;
+	int kernelSize		= 3;
+	int kernal1		= 1;
+	int kernal2		= 3;
+	int median		= 5;
+	int threshold		= 16;
+	int ascHeight		= 20;
+	String ramp		= DEFAULT_SHADE_RAMP;
+	bool fill		= false; // put shading behind the edge methods
+	int color		= 0; // 0 = none, 1 = 256 color, 2 = truecolor
+	bool angles		= false; // directional glyphs for canny, from its own gradients
+};
+
 // function declarations
 bool isWhite(Mat detectedEdges, int xMin, int xMax, int yMin, int yMax);
 static void simpleReplace(int ascHeight, int ascWidth, char* result, char* giant);
 static char * outlineToAscii(Mat src, int ascHeight);
+int asciiWidth(Mat src, int ascHeight);
+int asciiWidth(Size src, int ascHeight);
+Mat cellMeans(Mat src, int ascHeight, Size artSize, Mat* covered = NULL);
+void streamOutlineToAscii(Mat src, int ascHeight, FILE* out, Mat fill = Mat());
+void streamSobelToAscii(Mat src, int ascHeight, FILE* out, Mat fill = Mat());
+void streamAngleToAscii(Mat angle, int ascHeight, FILE* out, Mat fill = Mat());
+char * angleToAscii(Mat angle, int ascHeight);
+Mat shadeGlyphs(Mat srcGray, int ascHeight, String ramp);
+Mat fillGlyphs(Mat srcGray, int ascHeight, String ramp);
+char * shadeToAscii(Mat srcGray, int ascHeight, String ramp);
+void shadeFill(char* ascArt, Mat glyphs);
+char * colorizeAscii(const char* ascArt, Mat src, int colorMode, Size artSize = Size());
 void CannyThreshold(int, void*);
 void demoCannyImage(String fileName, int blurThreshold, int lowThreshold, int ratio, int kernelSize, int ascHeight);
 void demoGaussImage(String fileName, int kernalSize1, int kernalSize2, int medianBlurSize, int pixelThreshold, int ascHeight);
+Mat loadColorImage(String fileName);
+Mat loadGrayImage(String fileName);
+Mat cannyEdges(Mat srcGray, int blurThreshold, int lowThreshold, int ratio, int kernelSize);
+Mat cannyAngles(Mat srcGray, int blurThreshold, int lowThreshold, int ratio, int kernelSize);
+Mat gaussEdges(Mat srcGray, int kernalSize1, int kernalSize2, int medianBlurSize, int pixelThreshold);
+Mat preprocessImage(Mat srcGray, AsciiOptions opts);
+char* edgesToAscii(Mat detectedEdges, AsciiOptions opts);
 char* convertCannyImage(String fileName, int blurThreshold, int lowThreshold, int ratio, int kernelSize, int ascHeight);
-char* convertGaussImage(String fileName, int kernalSize1, int kernalSize2, int medianBlurSize, int pixelThreshold, int ascHeight);
\ No newline at end of file
+char* convertGaussImage(String fileName, int kernalSize1, int kernalSize2, int medianBlurSize, int pixelThreshold, int ascHeight);
+char* convertShadeImage(String fileName, String ramp, int ascHeight);
+char* convertGrayImage(Mat srcGray, AsciiOptions opts);
+char* convertImage(String fileName, AsciiOptions opts);
+bool streamImage(String fileName, AsciiOptions opts, FILE* out);
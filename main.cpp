@@ -3,6 +3,14 @@
 #include <iostream>
 #include <vector>
 #include "GenerateAscii.hpp"
+#include "AsciiCache.hpp"
+#include "AsciiPreview.hpp"
+#include "AsciiPlayback.hpp"
+#include "AsciiBatch.hpp"
+#include "AsciiWatch.hpp"
+#include "AsciiInput.hpp"
+#include "AsciiProgressive.hpp"
+#include "AsciiTiles.hpp"
 // #define DEBUG_MODE
 using namespace cv;
 
@@ -42,17 +50,24 @@ int main(int argc, char** argv)
 	
 	// set defaults and let args change if needed
 	bool isDemo = false;
+	bool isStream = false;
+	bool isProgressive = false;
+	bool isPlay = false;
+	int frameMs = DEFAULT_FRAME_MS;
 	String fileName;
-	int blurThreshold = 3;
-	int lowThreshold = 21;
-	int ratio = 4;
-	int kernelSize = 3; 
-	int ascHeight = 20;
-	int preProcess = 0; // 0 = Gauss, 1 = Canny
-	int kernal1 = 1;
-	int kernal2 = 3;
-	int median = 5;
-	int threshold = 16;
+	AsciiOptions opts;
+	String cacheDir;
+	String previewFile;
+	String manifest;
+	String batchDir = "batch";
+	int workers = 1;
+	int workerShard = -1;
+	bool spawnWorkers = true;
+	WatchSettings watch;
+	TileGeometry tiles;
+	String outputDir;
+	int rawWidth = 0, rawHeight = 0, rawChannels = 1;
+	long cacheSizeMB = DEFAULT_CACHE_SIZE_MB;
 
 	// iterate through args and set values accordingly
 	for(int i = 1 ; i < argc ; i++){
@@ -68,84 +83,217 @@ int main(int argc, char** argv)
 			std::cout << "	-l, --low		Sets the low threshold value for canny" << std::endl;
 			std::cout << "	-r, --ratio		Sets the ratio value for canny" << std::endl;
 			std::cout << "	-k, --kernel		Sets the kernel size value for canny. Must be 3, 5, or 7" << std::endl;
+			std::cout << "	-a, --angles		Picks canny characters by the direction of each outline, not just its shape" << std::endl;
 			std::cout << "	-c, --height		Sets the character height of the generated ascii art" << std::endl;
 			std::cout << "	-1, --kernal1		Sets the size of the first kernal for gauss" << std::endl;
 			std::cout << "	-2, --kernal2		Sets the size of the second kernal for gauss" << std::endl;
 			std::cout << "	-m, --median		Sets the size of the median blur for gauss" << std::endl;
 			std::cout << "	-t, --threshold		Sets the brighntess threshold for gauss" << std::endl;
-			std::cout << "	-p, --preprocess	Sets the preprocess method. Must be either \"canny\" or \"gauss\"\n "
+			std::cout << "	-p, --preprocess	Sets the preprocess method. Must be \"canny\", \"gauss\" or \"shade\"\n "
 				     "				Assumes gauss unless specified." << std::endl;
+			std::cout << "	-f, --fill		Fills the blank space around canny or gauss outlines with shading" << std::endl;
+			std::cout << "	--color			Colors the output for the terminal. Must be \"256\" or \"truecolor\". Not used with -s" << std::endl;
+			std::cout << "	--ramp			Sets the shading characters, ordered darkest to lightest. Defaults to \"" << DEFAULT_SHADE_RAMP << "\"" << std::endl;
+			std::cout << "	-s, --stream		Writes each row as soon as it is ready. Use for very tall output. Not cached" << std::endl;
+			std::cout << "	--play			Plays the file (or camera number) as video, lowering quality as needed to keep up" << std::endl;
+			std::cout << "	--frame-ms		Sets the target time for each frame of --play in milliseconds. Defaults to " << DEFAULT_FRAME_MS << std::endl;
+			std::cout << "	--manifest		Converts every image listed in the given file (one per line) as a batch" << std::endl;
+			std::cout << "	--workers		Sets the number of worker processes for --manifest. Defaults to 1" << std::endl;
+			std::cout << "	--batch-dir		Sets the directory for a batch's shards, checkpoints and results. Defaults to \"batch\"" << std::endl;
+			std::cout << "	--no-spawn		Waits for workers started by hand (see --worker) instead of starting them" << std::endl;
+			std::cout << "	--worker		Runs the given shard of the batch in --batch-dir" << std::endl;
+			std::cout << "	--watch			Converts each image dropped into the given directory until stopped" << std::endl;
+			std::cout << "	--output-dir		Sets where --watch and --tiles write their results" << std::endl;
+			std::cout << "	--threads		Sets the number of conversion threads for --watch. Defaults to one per core" << std::endl;
+			std::cout << "	--raw			Reads raw 8 bit frames of the given size (WIDTHxHEIGHT, or WIDTHxHEIGHTx3 for BGR)\n"
+				     "				from the file, FIFO or - for stdin, and converts each one" << std::endl;
+			std::cout << "	--tiles			Converts each WIDTHxHEIGHT tile of a sprite or contact sheet separately" << std::endl;
+			std::cout << "	--tile-spacing		Sets the gap in pixels between neighbouring tiles" << std::endl;
+			std::cout << "	--tile-margin		Sets the gap in pixels between the edge of the sheet and the tiles" << std::endl;
+			std::cout << "	--preview		Also draws the result into the given image file (png, jpg, ...). With --manifest,\n"
+				     "				--watch or --tiles each result gets a preview next to it, in that format" << std::endl;
+			std::cout << "	--progressive		Shows a rough result right away, then replaces it with sharper ones" << std::endl;
+			std::cout << "	--cache			Reuses results stored in the given directory, and stores new ones there" << std::endl;
+			std::cout << "	--cache-size		Sets the size limit of the cache in megabytes. Defaults to " << DEFAULT_CACHE_SIZE_MB << std::endl;
 			// TODO: detail everything as I add it... Just sets the default for demo, or actual for the normal.
 			return 0;
 		}
 		else if (!strcmp(argv[i], "-d") || !strcmp(argv[i], "--demo")){
 			isDemo = true;
 		}
+		else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--stream")){
+			isStream = true;
+		}
+		else if (!strcmp(argv[i], "--progressive")){
+			isProgressive = true;
+		}
 		else if (!strcmp(argv[i], "-b") || !strcmp(argv[i], "--blur")){
-			blurThreshold = std::stoi(argv[++i]);
-			if(blurThreshold < 1 || blurThreshold > MAX_BLUR_THRESHOLD) goto help;
+			opts.blurThreshold = std::stoi(argv[++i]);
+			if(opts.blurThreshold < 1 || opts.blurThreshold > MAX_BLUR_THRESHOLD) goto help;
 		}
 		else if (!strcmp(argv[i], "-l") || !strcmp(argv[i], "--low")){
-			lowThreshold = std::stoi(argv[++i]);
-			if(lowThreshold < 1 || lowThreshold > MAX_LOW_THRESHOLD) goto help;
+			opts.lowThreshold = std::stoi(argv[++i]);
+			if(opts.lowThreshold < 1 || opts.lowThreshold > MAX_LOW_THRESHOLD) goto help;
 		}else if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--ratio")){
-			ratio = std::stoi(argv[++i]);
-			if(ratio < 1 || ratio > MAX_RATIO) goto help;
+			opts.ratio = std::stoi(argv[++i]);
+			if(opts.ratio < 1 || opts.ratio > MAX_RATIO) goto help;
 		}else if (!strcmp(argv[i], "-k") || !strcmp(argv[i], "--kernel")){
-			kernelSize = std::stoi(argv[++i]);
-			if(kernelSize != 3 && kernelSize != 5 && kernelSize != 7) goto help;
+			opts.kernelSize = std::stoi(argv[++i]);
+			if(opts.kernelSize != 3 && opts.kernelSize != 5 && opts.kernelSize != 7) goto help;
+		}else if (!strcmp(argv[i], "-a") || !strcmp(argv[i], "--angles")){
+			opts.angles = true;
 		}else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--Height")){
-			ascHeight = std::stoi(argv[++i]);
-			if(ascHeight < 1 || ascHeight > MAX_ASCII_HEIGHT) goto help;
+			opts.ascHeight = std::stoi(argv[++i]);
+			if(opts.ascHeight < 1 || opts.ascHeight > MAX_ASCII_HEIGHT) goto help;
 		}else if (!strcmp(argv[i], "-1") || !strcmp(argv[i], "--kernal1")){
-			kernal1 = std::stoi(argv[++i]);
-			if(kernal1 < 1 || kernal1 > MAX_KERNAL_SIZE_1) goto help;
+			opts.kernal1 = std::stoi(argv[++i]);
+			if(opts.kernal1 < 1 || opts.kernal1 > MAX_KERNAL_SIZE_1) goto help;
 		}else if (!strcmp(argv[i], "-2") || !strcmp(argv[i], "--kernal2")){
-			kernal2 = std::stoi(argv[++i]);
-			if(kernal2 < 1 || kernal2 > MAX_KERNAL_SIZE_2) goto help;
+			opts.kernal2 = std::stoi(argv[++i]);
+			if(opts.kernal2 < 1 || opts.kernal2 > MAX_KERNAL_SIZE_2) goto help;
 		}else if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "--median")){
-			median = std::stoi(argv[++i]);
-			if(median < 1 || median > MAX_MEDIAN_BLUR_SIZE) goto help;
+			opts.median = std::stoi(argv[++i]);
+			if(opts.median < 1 || opts.median > MAX_MEDIAN_BLUR_SIZE) goto help;
 		}else if (!strcmp(argv[i], "-t") || !strcmp(argv[i], "--threshold")){
-			threshold = std::stoi(argv[++i]);
-			if(threshold < 1 || threshold > MAX_PIXEL_THRESHOLD) goto help;
+			opts.threshold = std::stoi(argv[++i]);
+			if(opts.threshold < 1 || opts.threshold > MAX_PIXEL_THRESHOLD) goto help;
 		}else if (!strcmp(argv[i], "-p") || !strcmp(argv[i], "--preprocess")){
 			i++;
-			if(!strcmp(argv[i], "canny")) preProcess = 1;
-			else if(!strcmp(argv[i], "gauss")) preProcess = 0;
+			if(!strcmp(argv[i], "canny")) opts.preProcess = 1;
+			else if(!strcmp(argv[i], "gauss")) opts.preProcess = 0;
+			else if(!strcmp(argv[i], "shade")) opts.preProcess = 2;
+			else goto help;
+		}else if (!strcmp(argv[i], "-f") || !strcmp(argv[i], "--fill")){
+			opts.fill = true;
+		}else if (!strcmp(argv[i], "--color")){
+			i++;
+			if(!strcmp(argv[i], "256")) opts.color = 1;
+			else if(!strcmp(argv[i], "truecolor")) opts.color = 2;
 			else goto help;
+		}else if (!strcmp(argv[i], "--ramp")){
+			opts.ramp = argv[++i];
+			if(opts.ramp.empty()) goto help;
+		}else if (!strcmp(argv[i], "--play")){
+			isPlay = true;
+		}else if (!strcmp(argv[i], "--frame-ms")){
+			frameMs = std::stoi(argv[++i]);
+			if(frameMs < 1 || frameMs > MAX_FRAME_MS) goto help;
+		}else if (!strcmp(argv[i], "--manifest")){
+			manifest = argv[++i];
+		}else if (!strcmp(argv[i], "--workers")){
+			workers = std::stoi(argv[++i]);
+			if(workers < 1 || workers > MAX_BATCH_WORKERS) goto help;
+		}else if (!strcmp(argv[i], "--batch-dir")){
+			batchDir = argv[++i];
+		}else if (!strcmp(argv[i], "--no-spawn")){
+			spawnWorkers = false;
+		}else if (!strcmp(argv[i], "--worker")){
+			workerShard = std::stoi(argv[++i]);
+			if(workerShard < 0 || workerShard >= MAX_BATCH_WORKERS) goto help;
+		}else if (!strcmp(argv[i], "--watch")){
+			watch.watchDir = argv[++i];
+		}else if (!strcmp(argv[i], "--output-dir")){
+			outputDir = argv[++i];
+		}else if (!strcmp(argv[i], "--threads")){
+			watch.threads = std::stoi(argv[++i]);
+			if(watch.threads < 1 || watch.threads > MAX_WATCH_THREADS) goto help;
+		}else if (!strcmp(argv[i], "--raw")){
+			int fields = sscanf(argv[++i], "%dx%dx%d", &rawWidth, &rawHeight, &rawChannels);
+			if(fields < 2 || rawWidth < 1 || rawHeight < 1 || rawWidth > MAX_RAW_DIMENSION
+			   || rawHeight > MAX_RAW_DIMENSION || (rawChannels != 1 && rawChannels != 3)) goto help;
+		}else if (!strcmp(argv[i], "--tiles")){
+			if(sscanf(argv[++i], "%dx%d", &tiles.width, &tiles.height) != 2) goto help;
+			if(tiles.width < 1 || tiles.height < 1 || tiles.width > MAX_RAW_DIMENSION || tiles.height > MAX_RAW_DIMENSION) goto help;
+		}else if (!strcmp(argv[i], "--tile-spacing")){
+			tiles.spacing = std::stoi(argv[++i]);
+			if(tiles.spacing < 0 || tiles.spacing > MAX_TILE_SPACING) goto help;
+		}else if (!strcmp(argv[i], "--tile-margin")){
+			tiles.margin = std::stoi(argv[++i]);
+			if(tiles.margin < 0 || tiles.margin > MAX_TILE_SPACING) goto help;
+		}else if (!strcmp(argv[i], "--preview")){
+			previewFile = argv[++i];
+		}else if (!strcmp(argv[i], "--cache")){
+			cacheDir = argv[++i];
+		}else if (!strcmp(argv[i], "--cache-size")){
+			cacheSizeMB = std::stol(argv[++i]);
+			if(cacheSizeMB < 1 || cacheSizeMB > MAX_CACHE_SIZE_MB) goto help;
 		}else{
 			// just assume it was the file name
 			fileName = argv[i];
 		}
 	}
 
-	char * result;
+	char * result = NULL;
+	BatchSettings batch;
+	batch.batchDir = batchDir;
+	batch.opts = opts;
+	if(!previewFile.empty()) batch.previewExt = previewExtension(previewFile);
+	if(!cacheDir.empty()){
+		batch.cacheDir = cacheDir;
+		batch.cacheBytes = cacheSizeMB * 1024 * 1024;
+	}
+
 	// determine if should demo or not
-	if(isDemo){
-		switch (preProcess){
+	if(workerShard >= 0){
+		// checked first, since workers are started with the coordinator's own arguments
+		return runBatchWorker(workerShard, batch);
+	}
+	else if(!manifest.empty()){
+		return runBatchCoordinator(manifest, workers, spawnWorkers, batch, argc, argv);
+	}
+	else if(rawWidth > 0){
+		return convertRawFrames(fileName, rawWidth, rawHeight, rawChannels, opts);
+	}
+	else if(tiles.width > 0){
+		return convertTiles(fileName, tiles, opts, outputDir, previewFile);
+	}
+	else if(!watch.watchDir.empty()){
+		watch.outputDir = outputDir;
+		watch.opts = opts;
+		watch.cacheDir = batch.cacheDir;
+		watch.cacheBytes = batch.cacheBytes;
+		watch.previewExt = batch.previewExt;
+		return watchFolder(watch);
+	}
+	else if(isDemo){
+		switch (opts.preProcess){
 			case 0:
-				demoGaussImage(fileName, kernal1, kernal2, median, threshold, ascHeight);
+				demoGaussImage(fileName, opts.kernal1, opts.kernal2, opts.median, opts.threshold, opts.ascHeight);
 				break;
 			case 1:
-				demoCannyImage(fileName, blurThreshold, lowThreshold, ratio, kernelSize, ascHeight);
+				demoCannyImage(fileName, opts.blurThreshold, opts.lowThreshold, opts.ratio, opts.kernelSize, opts.ascHeight);
 				break;
 			default:
 			break;
 		}
 	}
+	else if(isPlay){
+		if(!playVideo(fileName, opts, frameMs)) return -1;
+	}
+	else if(isProgressive){
+		if(!progressiveImage(fileName, opts, stdout)) return -1;
+	}
+	else if(isStream){
+		// rows go out through stdio with a large buffer rather than std::endl flushing every line
+		setvbuf(stdout, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+		if(!streamImage(fileName, opts, stdout)) return -1;
+	}
 	else{
-		switch (preProcess){
-			case 0:
-				result = convertGaussImage(fileName, blurThreshold, lowThreshold, ratio, kernelSize, ascHeight);
-				break;
-			case 1:
-				result = convertCannyImage(fileName, blurThreshold, lowThreshold, ratio, kernelSize, ascHeight);
-				break;
-			default:
-			break;
+		bool hit = false;
+		if(cacheDir.empty()) result = convertImage(fileName, opts);
+		else{
+			// a hit skips decoding the image entirely
+			result = convertImageCached(fileName, opts, cacheDir, cacheSizeMB * 1024 * 1024, &hit);
+			AsciiCacheStats stats = cacheStats(cacheDir);
+			std::cerr << "cache " << (hit ? "hit" : "miss") << " (" << stats.hits << " hits, "
+				  << stats.misses << " misses)" << std::endl;
 		}
+		if(!result) return -1;
+
 		std::cout << result << std::endl;
+		if(!previewFile.empty() && !writeAsciiPreview(result, previewFile)){
+			std::cerr << "Could not write the preview to " << previewFile << std::endl;
+		}
 		free(result);
 	} 
  	return 0; 